@@ -0,0 +1,613 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/allocator/allocator.h"
+#include "src/list/concurrent_queue.h"
+#include "src/list/intrusive_list.h"
+#include "src/list/list.h"
+#include "src/list/prefetch.h"
+#include "src/list/unrolled_list.h"
+
+// Side-by-side timings of task::List, task::UnrolledList and std::list.
+// Usage: bench [max_size]  (sizes run from 10^3 up to max_size, 10^7 by default)
+//
+// ns/op is per element touched, except for Move which is per move-assignment. allocs/op counts
+// calls into the global operator new, i.e. the requests a pool did not absorb.
+
+namespace {
+
+std::atomic<uint64_t> global_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+volatile uint64_t sink;
+
+template <typename T>
+T MakeValue(uint64_t i);
+
+template <>
+int MakeValue<int>(uint64_t i) {
+    return static_cast<int>(i);
+}
+
+template <>
+std::string MakeValue<std::string>(uint64_t i) {
+    return "value-" + std::to_string(i);
+}
+
+uint64_t Touch(int value) {
+    return static_cast<uint64_t>(value);
+}
+
+uint64_t Touch(const std::string& value) {
+    return value.size();
+}
+
+// The two interfaces differ only in spelling.
+template <typename T, typename A>
+void PushBack(task::List<T, A>& list, const T& value) {
+    list.PushBack(value);
+}
+template <typename T, typename A>
+void PushBack(task::UnrolledList<T, A>& list, const T& value) {
+    list.PushBack(value);
+}
+template <typename T, typename A>
+void PushBack(std::list<T, A>& list, const T& value) {
+    list.push_back(value);
+}
+template <typename T, typename A>
+void PushFront(task::List<T, A>& list, const T& value) {
+    list.PushFront(value);
+}
+template <typename T, typename A>
+void PushFront(task::UnrolledList<T, A>& list, const T& value) {
+    list.PushFront(value);
+}
+template <typename T, typename A>
+void PushFront(std::list<T, A>& list, const T& value) {
+    list.push_front(value);
+}
+template <typename T, typename A>
+void PopBack(task::List<T, A>& list) {
+    list.PopBack();
+}
+template <typename T, typename A>
+void PopBack(task::UnrolledList<T, A>& list) {
+    list.PopBack();
+}
+template <typename T, typename A>
+void PopBack(std::list<T, A>& list) {
+    list.pop_back();
+}
+template <typename T, typename A>
+void PopFront(task::List<T, A>& list) {
+    list.PopFront();
+}
+template <typename T, typename A>
+void PopFront(task::UnrolledList<T, A>& list) {
+    list.PopFront();
+}
+template <typename T, typename A>
+void PopFront(std::list<T, A>& list) {
+    list.pop_front();
+}
+template <typename T, typename A>
+void Clear(task::List<T, A>& list) {
+    list.Clear();
+}
+template <typename T, typename A>
+void Clear(task::UnrolledList<T, A>& list) {
+    list.Clear();
+}
+template <typename T, typename A>
+void Clear(std::list<T, A>& list) {
+    list.clear();
+}
+template <typename T, typename A>
+void Resize(task::List<T, A>& list, std::size_t count) {
+    list.Resize(count);
+}
+template <typename T, typename A>
+void Resize(task::UnrolledList<T, A>& list, std::size_t count) {
+    list.Resize(count);
+}
+template <typename T, typename A>
+void Resize(std::list<T, A>& list, std::size_t count) {
+    list.resize(count);
+}
+template <typename T, typename A>
+void Remove(task::List<T, A>& list, const T& value) {
+    list.Remove(value);
+}
+template <typename T, typename A>
+void Remove(task::UnrolledList<T, A>& list, const T& value) {
+    list.Remove(value);
+}
+template <typename T, typename A>
+void Remove(std::list<T, A>& list, const T& value) {
+    list.remove(value);
+}
+template <typename T, typename A>
+void Unique(task::List<T, A>& list) {
+    list.Unique();
+}
+template <typename T, typename A>
+void Unique(task::UnrolledList<T, A>& list) {
+    list.Unique();
+}
+template <typename T, typename A>
+void Unique(std::list<T, A>& list) {
+    list.unique();
+}
+template <typename T, typename A>
+void Sort(task::List<T, A>& list) {
+    list.Sort();
+}
+template <typename T, typename A>
+void Sort(task::UnrolledList<T, A>& list) {
+    list.Sort();
+}
+template <typename T, typename A>
+void Sort(std::list<T, A>& list) {
+    list.sort();
+}
+template <typename T, typename A>
+uint64_t Traverse(const task::List<T, A>& list) {
+    uint64_t sum = 0;
+    for (auto it = list.Begin(); it != list.End(); ++it) {
+        sum += Touch(*it);
+    }
+    return sum;
+}
+template <typename T, typename A>
+uint64_t Traverse(const task::UnrolledList<T, A>& list) {
+    uint64_t sum = 0;
+    for (auto it = list.Begin(); it != list.End(); ++it) {
+        sum += Touch(*it);
+    }
+    return sum;
+}
+template <typename T, typename A>
+uint64_t Traverse(const std::list<T, A>& list) {
+    uint64_t sum = 0;
+    for (const T& value : list) {
+        sum += Touch(value);
+    }
+    return sum;
+}
+
+struct Result {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// Runs `body` once after `setup`; `body` returns how many operations it performed.
+Result Measure(const std::function<void()>& setup, const std::function<uint64_t()>& body) {
+    setup();
+    uint64_t allocations = global_allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ops = body();
+    auto finish = std::chrono::steady_clock::now();
+    allocations = global_allocations.load(std::memory_order_relaxed) - allocations;
+    ops = std::max<uint64_t>(ops, 1);
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+    return {ns / static_cast<double>(ops),
+            static_cast<double>(allocations) / static_cast<double>(ops)};
+}
+
+void Report(const char* op, const char* container, const char* payload, std::size_t n,
+            Result result) {
+    std::printf("%-10s %-34s %-12s %9zu %10.2f %10.4f\n", op, container, payload, n,
+                result.ns_per_op, result.allocs_per_op);
+}
+
+template <typename List, typename T>
+void RunSuite(const char* container, const char* payload, std::size_t n,
+              const std::function<List()>& make) {
+    std::mt19937_64 random(n);
+    std::vector<T> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        values.push_back(MakeValue<T>(random() % (n / 10 + 1)));
+    }
+
+    auto fill = [&](List& list) {
+        for (const T& value : values) {
+            PushBack(list, value);
+        }
+    };
+    auto run = [&](const char* op, const std::function<void(List&)>& setup,
+                   const std::function<uint64_t(List&)>& body) {
+        List list = make();
+        Report(op, container, payload, n,
+               Measure([&] { setup(list); }, [&] { return body(list); }));
+    };
+    auto none = [](List&) {};
+    // Results of Copy and Move are parked here so their destruction is not timed.
+    std::vector<List> keep;
+
+    run("PushBack", none, [&](List& list) {
+        fill(list);
+        return n;
+    });
+    run("PushFront", none, [&](List& list) {
+        for (const T& value : values) {
+            PushFront(list, value);
+        }
+        return n;
+    });
+    run("PopBack", fill, [&](List& list) {
+        for (std::size_t i = 0; i < n; ++i) {
+            PopBack(list);
+        }
+        return n;
+    });
+    run("PopFront", fill, [&](List& list) {
+        for (std::size_t i = 0; i < n; ++i) {
+            PopFront(list);
+        }
+        return n;
+    });
+    run("Clear", fill, [&](List& list) {
+        Clear(list);
+        return n;
+    });
+    run("Traverse", fill, [&](List& list) {
+        sink = Traverse(list);
+        return n;
+    });
+    run("Copy", fill, [&](List& list) {
+        keep.emplace_back(list);
+        return n;
+    });
+    keep.clear();
+    keep.push_back(make());
+    run("Move", fill, [&](List& list) {
+        constexpr uint64_t kRounds = 1000;
+        for (uint64_t i = 0; i < kRounds; ++i) {
+            keep.back() = std::move(list);
+            list = std::move(keep.back());
+        }
+        return 2 * kRounds;
+    });
+    keep.clear();
+    run("Resize", none, [&](List& list) {
+        Resize(list, n);
+        return n;
+    });
+    run("Remove", fill, [&](List& list) {
+        Remove(list, values[n / 2]);
+        return n;
+    });
+    run("Unique", [&](List& list) {
+        for (const T& value : values) {
+            PushBack(list, value);
+            PushBack(list, value);
+        }
+    },
+        [&](List& list) {
+            Unique(list);
+            return 2 * n;
+        });
+    run("Sort", fill, [&](List& list) {
+        Sort(list);
+        return n;
+    });
+    run("Sorted",
+        [&](List& list) {
+            fill(list);
+            Sort(list);
+        },
+        [&](List& list) {
+            Sort(list);
+            return n;
+        });
+}
+
+// ParallelSort exists on task::List only, so it gets its own rows next to the serial Sort.
+template <typename T>
+void RunParallelSort(const char* payload, std::size_t n) {
+    std::mt19937_64 random(n);
+    task::List<T, CustomAllocator<T>> list;
+    for (std::size_t i = 0; i < n; ++i) {
+        list.PushBack(MakeValue<T>(random() % (n / 10 + 1)));
+    }
+    char container[64];
+    std::snprintf(container, sizeof(container), "task::List/CustomAllocator(x%u)",
+                  std::max(1u, std::thread::hardware_concurrency()));
+    Report("ParSort", container, payload, n, Measure([] {}, [&] {
+               list.ParallelSort();
+               return n;
+           }));
+}
+
+// Traversal of a list whose nodes are scattered (sorting random values relinks them out of
+// address order), then the cost of Compact and the same traversal afterwards.
+template <typename T>
+void RunCompact(const char* payload, std::size_t n) {
+    std::mt19937_64 random(n);
+    task::List<T, CustomAllocator<T>> list;
+    for (std::size_t i = 0; i < n; ++i) {
+        list.PushBack(MakeValue<T>(random()));
+    }
+    list.Sort();
+
+    const char* container = "task::List/CustomAllocator";
+    auto traverse = [&] {
+        sink = Traverse(list);
+        return n;
+    };
+    Report("Scattered", container, payload, n, Measure([] {}, traverse));
+    Report("Compact", container, payload, n, Measure([] {}, [&] {
+               list.Compact();
+               return n;
+           }));
+    Report("Compacted", container, payload, n, Measure([] {}, traverse));
+}
+
+// Scans and algorithms over a scattered list (sorting random values relinks its nodes out of
+// address order), where every step is a cache miss. Scan/Pf<k> go through Prefetched<k>; build with
+// -DTASK_PREFETCH_DISTANCE=0 to compare Remove, Unique and Sort without internal prefetching.
+template <typename T>
+void RunPrefetch(const char* payload, std::size_t n) {
+    std::mt19937_64 random(n);
+    task::List<T, CustomAllocator<T>> list;
+    for (std::size_t i = 0; i < n; ++i) {
+        list.PushBack(MakeValue<T>(random() % (n / 10 + 1)));
+    }
+    list.Sort();
+    // Shuffled values keep Remove, Unique and Sort below from seeing presorted input.
+    std::vector<T> shuffled(list.Begin(), list.End());
+    std::shuffle(shuffled.begin(), shuffled.end(), random);
+    std::copy(shuffled.begin(), shuffled.end(), list.Begin());
+
+    const char* container = "task::List(scattered)";
+    Report("Scan", container, payload, n, Measure([] {}, [&] {
+               sink = Traverse(list);
+               return n;
+           }));
+    auto prefetched_scan = [&](auto range) {
+        return [&list, range] {
+            uint64_t sum = 0;
+            for (const T& value : range) {
+                sum += Touch(value);
+            }
+            sink = sum;
+            return static_cast<uint64_t>(list.Size());
+        };
+    };
+    Report("Scan/Pf4", container, payload, n,
+           Measure([] {}, prefetched_scan(task::Prefetched<4>(list))));
+    Report("Scan/Pf16", container, payload, n,
+           Measure([] {}, prefetched_scan(task::Prefetched<16>(list))));
+    Report("Remove", container, payload, n, Measure([] {}, [&] {
+               list.Remove(MakeValue<T>(0));
+               return n;
+           }));
+    Report("Unique", container, payload, n, Measure([] {}, [&] {
+               list.Unique();
+               return n;
+           }));
+    Report("Sort", container, payload, n, Measure([] {}, [&] {
+               list.Sort();
+               return n;
+           }));
+}
+
+// Order-preserving RemoveDuplicates against the Sort + Unique it replaces, which reorders the list.
+template <typename T>
+void RunRemoveDuplicates(const char* payload, std::size_t n) {
+    std::mt19937_64 random(n);
+    task::List<T, CustomAllocator<T>> original;
+    for (std::size_t i = 0; i < n; ++i) {
+        original.PushBack(MakeValue<T>(random() % (n / 10 + 1)));
+    }
+    const char* container = "task::List/CustomAllocator";
+    task::List<T, CustomAllocator<T>> list;
+    Report("Dedup", container, payload, n, Measure([&] { list = original; }, [&] {
+               list.RemoveDuplicates();
+               return n;
+           }));
+    Report("SortUniq", container, payload, n, Measure([&] { list = original; }, [&] {
+               list.Sort();
+               list.Unique();
+               return n;
+           }));
+}
+
+// Linking objects that already exist into an IntrusiveList against copying the same values into
+// a task::List, plus Sort; the intrusive rows should report zero allocs/op.
+template <typename T>
+void RunIntrusive(const char* payload, std::size_t n) {
+    struct Item : task::IntrusiveListHook<> {
+        explicit Item(T value) : value(std::move(value)) {
+        }
+        T value;
+    };
+    std::mt19937_64 random(n);
+    std::vector<Item> items;
+    items.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        items.emplace_back(MakeValue<T>(random() % (n / 10 + 1)));
+    }
+
+    task::IntrusiveList<Item> intrusive;
+    auto by_value = [](const Item& lhs, const Item& rhs) { return lhs.value < rhs.value; };
+    const char* container = "task::IntrusiveList";
+    Report("Link", container, payload, n, Measure([] {}, [&] {
+               for (Item& item : items) {
+                   intrusive.PushBack(item);
+               }
+               return n;
+           }));
+    Report("Sort", container, payload, n, Measure([] {}, [&] {
+               intrusive.Sort(by_value);
+               return n;
+           }));
+    intrusive.Clear();
+
+    task::List<T, CustomAllocator<T>> list;
+    container = "task::List/CustomAllocator";
+    Report("Link", container, payload, n, Measure([] {}, [&] {
+               for (const Item& item : items) {
+                   list.PushBack(item.value);
+               }
+               return n;
+           }));
+    Report("Sort", container, payload, n, Measure([] {}, [&] {
+               list.Sort();
+               return n;
+           }));
+}
+
+// The mutex-guarded task::List work queue that MpmcQueue and MpscQueue replace.
+template <typename T>
+class LockedListQueue {
+public:
+    void Push(T value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        list_.PushBack(std::move(value));
+    }
+
+    std::optional<T> TryPop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (list_.Empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(list_.Front()));
+        list_.PopFront();
+        return value;
+    }
+
+private:
+    std::mutex mutex_;
+    task::List<T, CustomAllocator<T>> list_;
+};
+
+// n values split over `producers` threads and drained by `consumers` threads; ns/op is wall time
+// per value, thread start-up included.
+template <typename Queue, typename T>
+void RunQueue(const char* name, const char* payload, std::size_t n, std::size_t producers,
+              std::size_t consumers) {
+    Queue queue;
+    T value = MakeValue<T>(n);
+    char container[64];
+    std::snprintf(container, sizeof(container), "%s(%zup/%zuc)", name, producers, consumers);
+    Report("Queue", container, payload, n, Measure([] {}, [&] {
+               std::atomic<std::size_t> popped{0};
+               std::vector<std::thread> threads;
+               for (std::size_t p = 0; p < producers; ++p) {
+                   std::size_t count = n / producers + (p < n % producers ? 1 : 0);
+                   threads.emplace_back([&queue, &value, count] {
+                       for (std::size_t i = 0; i < count; ++i) {
+                           queue.Push(value);
+                       }
+                   });
+               }
+               for (std::size_t c = 0; c < consumers; ++c) {
+                   threads.emplace_back([&queue, &popped, n] {
+                       uint64_t sum = 0;
+                       while (popped.load(std::memory_order_relaxed) < n) {
+                           if (std::optional<T> value = queue.TryPop()) {
+                               sum += Touch(*value);
+                               popped.fetch_add(1, std::memory_order_relaxed);
+                           } else {
+                               std::this_thread::yield();
+                           }
+                       }
+                       sink = sum;
+                   });
+               }
+               for (std::thread& thread : threads) {
+                   thread.join();
+               }
+               return n;
+           }));
+}
+
+template <typename T>
+void RunConcurrentQueues(const char* payload, std::size_t n) {
+    using Locked = LockedListQueue<T>;
+    using Mpmc = task::MpmcQueue<T, CustomAllocator<T>>;
+    using Mpsc = task::MpscQueue<T, CustomAllocator<T>>;
+    for (std::size_t producers : {1, 2, 4}) {
+        RunQueue<Locked, T>("Mutex+List", payload, n, producers, 1);
+        RunQueue<Mpsc, T>("MpscQueue", payload, n, producers, 1);
+        RunQueue<Mpmc, T>("MpmcQueue", payload, n, producers, 1);
+    }
+    for (std::size_t threads : {2, 4}) {
+        RunQueue<Locked, T>("Mutex+List", payload, n, threads, threads);
+        RunQueue<Mpmc, T>("MpmcQueue", payload, n, threads, threads);
+    }
+}
+
+template <typename T>
+void RunPayload(const char* payload, std::size_t n) {
+    using TaskCustom = task::List<T, CustomAllocator<T>>;
+    using TaskStd = task::List<T, std::allocator<T>>;
+    using UnrolledCustom = task::UnrolledList<T, CustomAllocator<T>>;
+    using StdStd = std::list<T, std::allocator<T>>;
+
+    RunSuite<TaskCustom, T>("task::List/CustomAllocator", payload, n,
+                            [] { return TaskCustom(); });
+    RunSuite<TaskCustom, T>("task::List/CustomAllocator(mmap)", payload, n, [] {
+        auto pool = std::make_shared<Pool>(nullptr, ChunkSource(ChunkSource::Backing::kMmap));
+        return TaskCustom(CustomAllocator<T>(pool));
+    });
+    RunSuite<UnrolledCustom, T>("task::UnrolledList/CustomAllocator", payload, n,
+                                [] { return UnrolledCustom(); });
+    RunSuite<TaskStd, T>("task::List/std::allocator", payload, n, [] { return TaskStd(); });
+    RunSuite<StdStd, T>("std::list/std::allocator", payload, n, [] { return StdStd(); });
+    RunParallelSort<T>(payload, n);
+    RunCompact<T>(payload, n);
+    RunPrefetch<T>(payload, n);
+    RunRemoveDuplicates<T>(payload, n);
+    RunIntrusive<T>(payload, n);
+    RunConcurrentQueues<T>(payload, n);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    std::printf("%-10s %-34s %-12s %9s %10s %10s\n", "op", "container", "payload", "n", "ns/op",
+                "allocs/op");
+    for (std::size_t n = 1000; n <= max_size; n *= 10) {
+        RunPayload<int>("int", n);
+        RunPayload<std::string>("std::string", n);
+    }
+    return 0;
+}
@@ -1,18 +1,163 @@
+#pragma once
+
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <vector>
+
+#include "allocator_stats.h"
+#include "chunk_source.h"
+
+// Segregated free-list pool shared by all copies (and rebinds) of one CustomAllocator.
+// Requests up to kMaxPooledSize bytes are rounded up to a kAlignment multiple and served from a
+// per-size free list or carved from the current chunk; larger ones go straight to operator new.
+// Chunks come from a ChunkSource. A Pool is not thread-safe: give each thread its own allocator.
+class Pool {
+public:
+    static constexpr std::size_t kAlignment = alignof(std::max_align_t);
+    static constexpr std::size_t kMaxPooledSize = 512;
+    static constexpr std::size_t kChunkSize = ChunkSource::kDefaultChunkSize;
+    static_assert(kMaxPooledSize <= ChunkSource::kMinChunkSize,
+                  "Carve needs every pooled request to fit in one chunk");
+
+    explicit Pool(std::shared_ptr<AllocatorStats> stats = nullptr,
+                  ChunkSource source = ChunkSource())
+        : source_(source), stats_(std::move(stats)) {
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    ~Pool() {
+        for (void* chunk : chunks_) {
+            source_.Release(chunk);
+        }
+    }
+
+    // Obtains chunks for at least `bytes` of nodes up front, e.g. at startup with a prefaulting
+    // source, so the first pass over a new list does not take page faults.
+    void Reserve(std::size_t bytes) {
+        std::size_t chunk_size = source_.ChunkSize();
+        std::size_t available =
+            spare_chunks_.size() * chunk_size + static_cast<std::size_t>(chunk_end_ - chunk_cur_);
+        for (; available < bytes; available += chunk_size) {
+            spare_chunks_.push_back(NewChunk());
+        }
+    }
+
+    void* Allocate(std::size_t bytes) {
+        if (bytes > kMaxPooledSize) {
+            void* p = ::operator new(bytes);
+            if (stats_) {
+                stats_->RecordAllocation(bytes);
+                stats_->RecordPoolLookup(false);
+            }
+            return p;
+        }
+
+        std::size_t size_class = SizeClass(bytes);
+        FreeBlock*& head = free_lists_[size_class];
+        bool hit = head != nullptr;
+        void* p;
+        if (hit) {
+            p = head;
+            head = head->next;
+        } else {
+            p = Carve((size_class + 1) * kAlignment);
+        }
+        if (stats_) {
+            stats_->RecordAllocation(bytes);
+            stats_->RecordPoolLookup(hit);
+        }
+        return p;
+    }
+
+    void Deallocate(void* p, std::size_t bytes) noexcept {
+        if (stats_) {
+            stats_->RecordDeallocation(bytes);
+        }
+        if (bytes > kMaxPooledSize) {
+            ::operator delete(p);
+            return;
+        }
+
+        FreeBlock*& head = free_lists_[SizeClass(bytes)];
+        head = ::new (p) FreeBlock{head};
+    }
+
+    const std::shared_ptr<AllocatorStats>& Stats() const noexcept {
+        return stats_;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t kSizeClasses = kMaxPooledSize / kAlignment;
+
+    static std::size_t SizeClass(std::size_t bytes) noexcept {
+        return bytes == 0 ? 0 : (bytes - 1) / kAlignment;
+    }
+
+    void* Carve(std::size_t bytes) {
+        if (static_cast<std::size_t>(chunk_end_ - chunk_cur_) < bytes) {
+            if (spare_chunks_.empty()) {
+                chunk_cur_ = static_cast<char*>(NewChunk());
+            } else {
+                chunk_cur_ = static_cast<char*>(spare_chunks_.back());
+                spare_chunks_.pop_back();
+            }
+            chunk_end_ = chunk_cur_ + source_.ChunkSize();
+        }
+        void* p = chunk_cur_;
+        chunk_cur_ += bytes;
+        return p;
+    }
+
+    void* NewChunk() {
+        chunks_.reserve(chunks_.size() + 1);
+        void* chunk = source_.Allocate();
+        chunks_.push_back(chunk);
+        if (stats_) {
+            stats_->RecordChunk(source_.ChunkSize());
+        }
+        return chunk;
+    }
+
+    FreeBlock* free_lists_[kSizeClasses] = {};
+    char* chunk_cur_ = nullptr;
+    char* chunk_end_ = nullptr;
+    std::vector<void*> chunks_;
+    std::vector<void*> spare_chunks_;
+    ChunkSource source_;
+    std::shared_ptr<AllocatorStats> stats_;
+};
 
 template <typename T>
 class CustomAllocator {
 public:
     template <typename U>
     struct rebind {  // NOLINT
-        // Your code goes here
+        using other = CustomAllocator<U>;
     };
 
     using value_type = T;
-    // Your code goes here
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
 
     CustomAllocator();
+    explicit CustomAllocator(std::shared_ptr<AllocatorStats> stats);
+    explicit CustomAllocator(std::shared_ptr<Pool> pool) noexcept;
     CustomAllocator(const CustomAllocator& other) noexcept;
     ~CustomAllocator();
 
@@ -20,34 +165,75 @@ public:
     explicit CustomAllocator(const CustomAllocator<U>& other) noexcept;
 
     T* allocate(size_t n) {  // NOLINT
-        // Your code goes here        
+        if (alignof(T) > Pool::kAlignment) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+        return static_cast<T*>(pool_->Allocate(n * sizeof(T)));
     }
     void deallocate(T* p, size_t n) {  // NOLINT
-        // Your code goes here
+        if (alignof(T) > Pool::kAlignment) {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+            return;
+        }
+        pool_->Deallocate(p, n * sizeof(T));
     };
     template <typename... Args>
     void construct(pointer p, Args&&... args) {  // NOLINT
-        // Your code goes here
+        ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
     };
     void destroy(pointer p) {  // NOLINT
-        // Your code goes here
+        p->~T();
     };
 
+    // Statistics the pool reports into, or nullptr when instrumentation is off.
+    const std::shared_ptr<AllocatorStats>& Stats() const noexcept {
+        return pool_->Stats();
+    }
+
     template <typename K, typename U>
     friend bool operator==(const CustomAllocator<K>& lhs, const CustomAllocator<U>& rhs) noexcept;
     template <typename K, typename U>
     friend bool operator!=(const CustomAllocator<K>& lhs, const CustomAllocator<U>& rhs) noexcept;
 
 private:
-    // Your code goes here
+    template <typename U>
+    friend class CustomAllocator;
+
+    std::shared_ptr<Pool> pool_;
 };
 
+template <typename T>
+CustomAllocator<T>::CustomAllocator() : pool_(std::make_shared<Pool>()) {
+}
+
+template <typename T>
+CustomAllocator<T>::CustomAllocator(std::shared_ptr<AllocatorStats> stats)
+    : pool_(std::make_shared<Pool>(std::move(stats))) {
+}
+
+template <typename T>
+CustomAllocator<T>::CustomAllocator(std::shared_ptr<Pool> pool) noexcept : pool_(std::move(pool)) {
+}
+
+template <typename T>
+CustomAllocator<T>::CustomAllocator(const CustomAllocator& other) noexcept : pool_(other.pool_) {
+}
+
+template <typename T>
+CustomAllocator<T>::~CustomAllocator() = default;
+
+template <typename T>
+template <typename U>
+CustomAllocator<T>::CustomAllocator(const CustomAllocator<U>& other) noexcept
+    : pool_(other.pool_) {
+}
+
 template <typename T, typename U>
 bool operator==(const CustomAllocator<T>& lhs, const CustomAllocator<U>& rhs) noexcept {
-    // Your code goes here
+    return lhs.pool_ == rhs.pool_;
 }
 
 template <typename T, typename U>
 bool operator!=(const CustomAllocator<T>& lhs, const CustomAllocator<U>& rhs) noexcept {
-    // Your code goes here
-}
\ No newline at end of file
+    return !(lhs == rhs);
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Optional instrumentation for CustomAllocator.
+//
+// Counters are sharded per thread (each thread picks a shard once) so that pools living on
+// different threads can report into one AllocatorStats without bouncing a single cache line.
+// Live and peak bytes are global atomics: the peak has to see a consistent total.
+class AllocatorStats {
+public:
+    static constexpr std::size_t kShards = 16;
+    static constexpr std::size_t kHistogramBuckets = 24;
+    static constexpr std::size_t kMaxCallSites = 64;
+
+    struct CallSite {
+        const char* name = nullptr;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Snapshot {
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t bytes_allocated = 0;
+        uint64_t bytes_deallocated = 0;
+        int64_t live_bytes = 0;
+        int64_t peak_bytes = 0;
+        uint64_t pool_hits = 0;
+        uint64_t pool_misses = 0;
+        uint64_t chunks = 0;
+        uint64_t chunk_bytes = 0;
+        // histogram[i] counts requests of size in (2^(i-1), 2^i]
+        std::array<uint64_t, kHistogramBuckets> histogram{};
+        std::vector<CallSite> call_sites;
+
+        double PoolHitRate() const {
+            uint64_t total = pool_hits + pool_misses;
+            return total == 0 ? 0.0 : static_cast<double>(pool_hits) / static_cast<double>(total);
+        }
+    };
+
+    // Attributes allocations made by the current thread to `name` while alive.
+    // `name` must outlive the stats object; string literals are the intended use.
+    class ScopedCallSite {
+    public:
+        explicit ScopedCallSite(const char* name) noexcept : previous_(current_site) {
+            current_site = name;
+        }
+        ~ScopedCallSite() {
+            current_site = previous_;
+        }
+
+        ScopedCallSite(const ScopedCallSite&) = delete;
+        ScopedCallSite& operator=(const ScopedCallSite&) = delete;
+
+    private:
+        friend class AllocatorStats;
+        static inline thread_local const char* current_site = nullptr;
+
+        const char* previous_;
+    };
+
+    AllocatorStats() = default;
+    AllocatorStats(const AllocatorStats&) = delete;
+    AllocatorStats& operator=(const AllocatorStats&) = delete;
+
+    void RecordAllocation(std::size_t bytes) noexcept {
+        Shard& shard = shards_[ThisThreadShard()];
+        shard.allocations.fetch_add(1, std::memory_order_relaxed);
+        shard.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+        shard.histogram[HistogramBucket(bytes)].fetch_add(1, std::memory_order_relaxed);
+
+        int64_t live =
+            live_bytes_.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+            static_cast<int64_t>(bytes);
+        int64_t peak = peak_bytes_.load(std::memory_order_relaxed);
+        while (live > peak &&
+               !peak_bytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+
+        if (const char* site = ScopedCallSite::current_site) {
+            SiteSlot& slot = FindSite(site);
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    void RecordDeallocation(std::size_t bytes) noexcept {
+        Shard& shard = shards_[ThisThreadShard()];
+        shard.deallocations.fetch_add(1, std::memory_order_relaxed);
+        shard.bytes_deallocated.fetch_add(bytes, std::memory_order_relaxed);
+        live_bytes_.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    // Only pools call this, so the hit rate is not diluted by unpooled resources.
+    void RecordPoolLookup(bool hit) noexcept {
+        Shard& shard = shards_[ThisThreadShard()];
+        (hit ? shard.pool_hits : shard.pool_misses).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordChunk(std::size_t bytes) noexcept {
+        Shard& shard = shards_[ThisThreadShard()];
+        shard.chunks.fetch_add(1, std::memory_order_relaxed);
+        shard.chunk_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    Snapshot Collect() const {
+        Snapshot snapshot;
+        for (const Shard& shard : shards_) {
+            snapshot.allocations += shard.allocations.load(std::memory_order_relaxed);
+            snapshot.deallocations += shard.deallocations.load(std::memory_order_relaxed);
+            snapshot.bytes_allocated += shard.bytes_allocated.load(std::memory_order_relaxed);
+            snapshot.bytes_deallocated += shard.bytes_deallocated.load(std::memory_order_relaxed);
+            snapshot.pool_hits += shard.pool_hits.load(std::memory_order_relaxed);
+            snapshot.pool_misses += shard.pool_misses.load(std::memory_order_relaxed);
+            snapshot.chunks += shard.chunks.load(std::memory_order_relaxed);
+            snapshot.chunk_bytes += shard.chunk_bytes.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < kHistogramBuckets; ++i) {
+                snapshot.histogram[i] += shard.histogram[i].load(std::memory_order_relaxed);
+            }
+        }
+        snapshot.live_bytes = live_bytes_.load(std::memory_order_relaxed);
+        snapshot.peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+        for (const SiteSlot& slot : sites_) {
+            const char* name = slot.name.load(std::memory_order_acquire);
+            if (name == nullptr) {
+                break;
+            }
+            snapshot.call_sites.push_back({name, slot.allocations.load(std::memory_order_relaxed),
+                                           slot.bytes.load(std::memory_order_relaxed)});
+        }
+        return snapshot;
+    }
+
+    void Dump(std::ostream& out) const {
+        Snapshot snapshot = Collect();
+        out << "allocations:   " << snapshot.allocations << '\n'
+            << "deallocations: " << snapshot.deallocations << '\n'
+            << "live bytes:    " << snapshot.live_bytes << '\n'
+            << "peak bytes:    " << snapshot.peak_bytes << '\n'
+            << "pool hit rate: " << snapshot.PoolHitRate() << " (" << snapshot.pool_hits << '/'
+            << snapshot.pool_hits + snapshot.pool_misses << ")\n"
+            << "chunks:        " << snapshot.chunks << " (" << snapshot.chunk_bytes << " bytes)\n"
+            << "size histogram:\n";
+        for (std::size_t i = 0; i < kHistogramBuckets; ++i) {
+            if (snapshot.histogram[i] != 0) {
+                out << "  <= " << (uint64_t{1} << i) << ": " << snapshot.histogram[i] << '\n';
+            }
+        }
+        if (!snapshot.call_sites.empty()) {
+            out << "call sites:\n";
+            for (const CallSite& site : snapshot.call_sites) {
+                out << "  " << site.name << ": " << site.allocations << " allocations, "
+                    << site.bytes << " bytes\n";
+            }
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> deallocations{0};
+        std::atomic<uint64_t> bytes_allocated{0};
+        std::atomic<uint64_t> bytes_deallocated{0};
+        std::atomic<uint64_t> pool_hits{0};
+        std::atomic<uint64_t> pool_misses{0};
+        std::atomic<uint64_t> chunks{0};
+        std::atomic<uint64_t> chunk_bytes{0};
+        std::array<std::atomic<uint64_t>, kHistogramBuckets> histogram{};
+    };
+
+    struct SiteSlot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    static std::size_t ThisThreadShard() noexcept {
+        static std::atomic<std::size_t> next_shard{0};
+        thread_local std::size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    static std::size_t HistogramBucket(std::size_t bytes) noexcept {
+        std::size_t bucket = 0;
+        while (bucket + 1 < kHistogramBuckets && (std::size_t{1} << bucket) < bytes) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // Slots are claimed in order and never released; the last one collects overflow.
+    SiteSlot& FindSite(const char* name) noexcept {
+        for (std::size_t i = 0; i + 1 < kMaxCallSites; ++i) {
+            const char* current = sites_[i].name.load(std::memory_order_acquire);
+            if (current == nullptr &&
+                sites_[i].name.compare_exchange_strong(current, name, std::memory_order_acq_rel)) {
+                return sites_[i];
+            }
+            if (current == name) {
+                return sites_[i];
+            }
+        }
+        const char* expected = nullptr;
+        sites_[kMaxCallSites - 1].name.compare_exchange_strong(expected, "<other>",
+                                                               std::memory_order_acq_rel);
+        return sites_[kMaxCallSites - 1];
+    }
+
+    std::array<Shard, kShards> shards_;
+    std::array<SiteSlot, kMaxCallSites> sites_;
+    std::atomic<int64_t> live_bytes_{0};
+    std::atomic<int64_t> peak_bytes_{0};
+};
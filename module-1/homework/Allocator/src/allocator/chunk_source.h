@@ -0,0 +1,119 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Where a Pool gets its chunks from.
+//
+// kHeap uses operator new. kMmap maps anonymous memory aligned to kHugePageSize and asks for
+// transparent huge pages with MADV_HUGEPAGE. kHugePages tries explicit MAP_HUGETLB pages first
+// and falls back to kMmap when none are reserved. Pools with tens of millions of nodes spend
+// less time in TLB misses on huge pages. Chunk sizes below kMinChunkSize are raised to it, and the
+// mmap backings round the chunk size up to a whole number of huge pages.
+class ChunkSource {
+public:
+    enum class Backing { kHeap, kMmap, kHugePages };
+
+    static constexpr std::size_t kDefaultChunkSize = 64 * 1024;
+    static constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+    static constexpr std::size_t kPageSize = 4096;
+    // A Pool carves each pooled request from a single chunk, so a chunk must hold the largest one.
+    static constexpr std::size_t kMinChunkSize = kPageSize;
+
+    // With `prefault` every page of a chunk is touched when the chunk is obtained, so that page
+    // faults are paid up front (see Pool::Reserve) rather than on the first node written.
+    explicit ChunkSource(Backing backing = Backing::kHeap,
+                         std::size_t chunk_size = kDefaultChunkSize, bool prefault = false)
+        : backing_(backing), chunk_size_(std::max(chunk_size, kMinChunkSize)), prefault_(prefault) {
+        if (backing_ != Backing::kHeap) {
+            chunk_size_ = (chunk_size_ + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        }
+    }
+
+    std::size_t ChunkSize() const noexcept {
+        return chunk_size_;
+    }
+
+    // The backing actually in use: kHugePages degrades to kMmap after a failed MAP_HUGETLB.
+    Backing EffectiveBacking() const noexcept {
+        return backing_;
+    }
+
+    void* Allocate() {
+        void* chunk = nullptr;
+        switch (backing_) {
+            case Backing::kHeap:
+                chunk = ::operator new(chunk_size_);
+                break;
+            case Backing::kHugePages:
+                chunk = MapHugeTlb();
+                if (chunk != nullptr) {
+                    break;
+                }
+                backing_ = Backing::kMmap;
+                [[fallthrough]];
+            case Backing::kMmap:
+                chunk = MapTransparent();
+                break;
+        }
+        if (prefault_) {
+            Prefault(chunk);
+        }
+        return chunk;
+    }
+
+    void Release(void* chunk) noexcept {
+        if (backing_ == Backing::kHeap) {
+            ::operator delete(chunk);
+        } else {
+            munmap(chunk, chunk_size_);
+        }
+    }
+
+private:
+    void* MapHugeTlb() noexcept {
+#ifdef MAP_HUGETLB
+        void* p = mmap(nullptr, chunk_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            return p;
+        }
+#endif
+        return nullptr;
+    }
+
+    // Over-map by one huge page and trim, so the chunk starts on a huge page boundary.
+    void* MapTransparent() {
+        std::size_t length = chunk_size_ + kHugePageSize;
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto begin = reinterpret_cast<std::uintptr_t>(p);
+        std::uintptr_t aligned = (begin + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        std::size_t head = aligned - begin;
+        if (head != 0) {
+            munmap(p, head);
+        }
+        munmap(reinterpret_cast<void*>(aligned + chunk_size_), kHugePageSize - head);
+#ifdef MADV_HUGEPAGE
+        madvise(reinterpret_cast<void*>(aligned), chunk_size_, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void Prefault(void* chunk) const noexcept {
+        auto* bytes = static_cast<volatile char*>(chunk);
+        for (std::size_t offset = 0; offset < chunk_size_; offset += kPageSize) {
+            bytes[offset] = 0;
+        }
+    }
+
+    Backing backing_;
+    std::size_t chunk_size_;
+    bool prefault_;
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "allocator_stats.h"
+#include "chunk_source.h"
+
+// Runtime-selectable allocation strategy, modelled after std::pmr::memory_resource.
+// Containers parameterized with PolymorphicAllocator share one type whatever resource backs them.
+class MemoryResource {
+public:
+    static constexpr std::size_t kDefaultAlignment = alignof(std::max_align_t);
+
+    virtual ~MemoryResource() = default;
+
+    void* Allocate(std::size_t bytes, std::size_t alignment = kDefaultAlignment) {
+        return DoAllocate(bytes, alignment);
+    }
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment = kDefaultAlignment) {
+        DoDeallocate(p, bytes, alignment);
+    }
+    bool IsEqual(const MemoryResource& other) const noexcept {
+        return this == &other || DoIsEqual(other);
+    }
+
+private:
+    virtual void* DoAllocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void DoDeallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+    virtual bool DoIsEqual(const MemoryResource& other) const noexcept {
+        return false;
+    }
+};
+
+// Global operator new / delete.
+class MallocResource : public MemoryResource {
+private:
+    void* DoAllocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > kDefaultAlignment) {
+            return ::operator new(bytes, std::align_val_t{alignment});
+        }
+        return ::operator new(bytes);
+    }
+    void DoDeallocate(void* p, std::size_t, std::size_t alignment) override {
+        if (alignment > kDefaultAlignment) {
+            ::operator delete(p, std::align_val_t{alignment});
+            return;
+        }
+        ::operator delete(p);
+    }
+    bool DoIsEqual(const MemoryResource& other) const noexcept override {
+        return dynamic_cast<const MallocResource*>(&other) != nullptr;
+    }
+};
+
+inline MemoryResource* DefaultResource() noexcept {
+    static MallocResource resource;
+    return &resource;
+}
+
+// The same segregated free-list Pool that backs CustomAllocator.
+class PoolResource : public MemoryResource {
+public:
+    explicit PoolResource(std::shared_ptr<AllocatorStats> stats = nullptr,
+                          ChunkSource source = ChunkSource())
+        : pool_(std::move(stats), source) {
+    }
+
+    void Reserve(std::size_t bytes) {
+        pool_.Reserve(bytes);
+    }
+
+private:
+    void* DoAllocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > Pool::kAlignment) {
+            return DefaultResource()->Allocate(bytes, alignment);
+        }
+        return pool_.Allocate(bytes);
+    }
+    void DoDeallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (alignment > Pool::kAlignment) {
+            DefaultResource()->Deallocate(p, bytes, alignment);
+            return;
+        }
+        pool_.Deallocate(p, bytes);
+    }
+
+    Pool pool_;
+};
+
+// Monotonic bump allocator: Deallocate is a no-op, memory comes back on Release() or
+// destruction. Suited to request-scoped containers that are dropped as a whole. Blocks start at
+// `initial_size`, raised to kDefaultAlignment so that doubling it always makes progress.
+class ArenaResource : public MemoryResource {
+public:
+    explicit ArenaResource(std::size_t initial_size = Pool::kChunkSize,
+                           MemoryResource* upstream = DefaultResource())
+        : next_size_(std::max(initial_size, kDefaultAlignment)), upstream_(upstream) {
+    }
+
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+
+    ~ArenaResource() override {
+        Release();
+    }
+
+    void Release() noexcept {
+        for (const std::pair<void*, std::size_t>& block : blocks_) {
+            upstream_->Deallocate(block.first, block.second);
+        }
+        blocks_.clear();
+        cur_ = nullptr;
+        end_ = nullptr;
+    }
+
+private:
+    void* DoAllocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = Bump(bytes, alignment);
+        if (p == nullptr) {
+            std::size_t size = next_size_;
+            while (size < bytes + alignment) {
+                size *= 2;
+            }
+            blocks_.reserve(blocks_.size() + 1);
+            cur_ = static_cast<char*>(upstream_->Allocate(size));
+            end_ = cur_ + size;
+            blocks_.emplace_back(cur_, size);
+            next_size_ = size * 2;
+            p = Bump(bytes, alignment);
+        }
+        return p;
+    }
+    void DoDeallocate(void*, std::size_t, std::size_t) override {
+    }
+
+    void* Bump(std::size_t bytes, std::size_t alignment) noexcept {
+        if (cur_ == nullptr) {
+            return nullptr;
+        }
+        void* p = cur_;
+        auto space = static_cast<std::size_t>(end_ - cur_);
+        if (std::align(alignment, bytes, p, space) == nullptr) {
+            return nullptr;
+        }
+        cur_ = static_cast<char*>(p) + bytes;
+        return p;
+    }
+
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t next_size_;
+    std::vector<std::pair<void*, std::size_t>> blocks_;
+    MemoryResource* upstream_;
+};
+
+// Forwards to an upstream resource and reports every call into AllocatorStats. Equal only to
+// itself: memory it hands out must also come back through it, or the stats drift.
+class InstrumentedResource : public MemoryResource {
+public:
+    InstrumentedResource(MemoryResource* upstream, std::shared_ptr<AllocatorStats> stats)
+        : upstream_(upstream), stats_(std::move(stats)) {
+    }
+
+    const std::shared_ptr<AllocatorStats>& Stats() const noexcept {
+        return stats_;
+    }
+
+private:
+    void* DoAllocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = upstream_->Allocate(bytes, alignment);
+        stats_->RecordAllocation(bytes);
+        return p;
+    }
+    void DoDeallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        stats_->RecordDeallocation(bytes);
+        upstream_->Deallocate(p, bytes, alignment);
+    }
+
+    MemoryResource* upstream_;
+    std::shared_ptr<AllocatorStats> stats_;
+};
+
+// Allocator that forwards to a MemoryResource it does not own.
+// Like std::pmr::polymorphic_allocator it never propagates: a container keeps its resource for
+// life, and copies of a container start on the default resource.
+template <typename T>
+class PolymorphicAllocator {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+
+    PolymorphicAllocator() noexcept : resource_(DefaultResource()) {
+    }
+    explicit PolymorphicAllocator(MemoryResource* resource) noexcept : resource_(resource) {
+    }
+    PolymorphicAllocator(const PolymorphicAllocator& other) noexcept = default;
+
+    template <typename U>
+    explicit PolymorphicAllocator(const PolymorphicAllocator<U>& other) noexcept
+        : resource_(other.Resource()) {
+    }
+
+    PolymorphicAllocator& operator=(const PolymorphicAllocator&) = delete;
+
+    T* allocate(size_t n) {  // NOLINT
+        return static_cast<T*>(resource_->Allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t n) {  // NOLINT
+        resource_->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+    template <typename... Args>
+    void construct(pointer p, Args&&... args) {  // NOLINT
+        ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+    }
+    void destroy(pointer p) {  // NOLINT
+        p->~T();
+    }
+
+    PolymorphicAllocator select_on_container_copy_construction() const {  // NOLINT
+        return PolymorphicAllocator();
+    }
+
+    MemoryResource* Resource() const noexcept {
+        return resource_;
+    }
+
+private:
+    MemoryResource* resource_;
+};
+
+template <typename T, typename U>
+bool operator==(const PolymorphicAllocator<T>& lhs, const PolymorphicAllocator<U>& rhs) noexcept {
+    return lhs.Resource()->IsEqual(*rhs.Resource());
+}
+
+template <typename T, typename U>
+bool operator!=(const PolymorphicAllocator<T>& lhs, const PolymorphicAllocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
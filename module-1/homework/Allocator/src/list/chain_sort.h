@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "prefetch.h"
+
+namespace task {
+
+// Bottom-up natural merge sort over null-terminated chains of nodes, shared by task::List and
+// task::IntrusiveList. Runs are fed into binary-counter bins, where bins[i] holds the merge of 2^i
+// runs, so each merge works on recently touched nodes and the whole sort needs only the fixed bins
+// array. The sort is stable, only relinks nodes and is O(n) on sorted input.
+//
+// Links supplies `static Node*& Next(Node* node) noexcept`. The comparator is called as
+// `less(lhs, rhs)` on two nodes and may throw: every function here then leaves each node on
+// exactly one of the chains it was given, in unspecified order, so the caller can relink them.
+template <typename Node, typename Links>
+class ChainSort {
+public:
+    // Sorts `chain` in place.
+    template <typename Less>
+    static void Sort(Node*& chain, Less& less);
+
+    // Stable merge of the sorted chain `rhs` into the sorted chain `lhs`.
+    template <typename Less>
+    static void Merge(Node*& lhs, Node* rhs, Less& less);
+
+    // Appends chain `rhs` to chain `lhs`, either of which may be empty; returns the head. Walks
+    // `lhs`.
+    static Node* Concat(Node* lhs, Node* rhs) noexcept {
+        if (lhs == nullptr) {
+            return rhs;
+        }
+        Node* last = lhs;
+        while (Links::Next(last) != nullptr) {
+            last = Links::Next(last);
+        }
+        Links::Next(last) = rhs;
+        return lhs;
+    }
+
+private:
+    // Prefetches kPrefetchDistance nodes ahead of a walk down a chain.
+    class Lookahead {
+    public:
+        explicit Lookahead(Node* first) noexcept : node_(first) {
+            for (std::size_t i = 0; i < kPrefetchDistance; ++i) {
+                Advance();
+            }
+        }
+
+        void Advance() noexcept {
+            if (kPrefetchDistance > 0 && node_ != nullptr) {
+                node_ = Links::Next(node_);
+                Prefetch(node_);
+            }
+        }
+
+    private:
+        Node* node_;
+    };
+
+    // Returns the last node of the non-decreasing run starting at `first`.
+    template <typename Less>
+    static Node* RunEnd(Node* first, Less& less) {
+        Node* last = first;
+        Lookahead ahead(first);
+        while (Links::Next(last) != nullptr && !less(Links::Next(last), last)) {
+            last = Links::Next(last);
+            ahead.Advance();
+        }
+        return last;
+    }
+};
+
+template <typename Node, typename Links>
+template <typename Less>
+void ChainSort<Node, Links>::Sort(Node*& chain, Less& less) {
+    constexpr std::size_t kBins = 64;
+    Node* bins[kBins] = {};
+    std::size_t used = 0;
+    // Each node is on exactly one of `chain`, `run` and the bins.
+    Node* run = nullptr;
+    try {
+        while (chain != nullptr) {
+            Node* last = RunEnd(chain, less);
+            run = chain;
+            chain = Links::Next(last);
+            Links::Next(last) = nullptr;
+
+            // Older runs are always the left operand, which keeps the sort stable.
+            std::size_t bin = 0;
+            for (; bin < used && bins[bin] != nullptr; ++bin) {
+                Node* newer = run;
+                run = bins[bin];
+                bins[bin] = nullptr;
+                Merge(run, newer, less);
+            }
+            bins[bin] = run;
+            run = nullptr;
+            used = std::max(used, bin + 1);
+        }
+
+        for (std::size_t bin = 0; bin < used; ++bin) {
+            if (bins[bin] != nullptr) {
+                Node* newer = run;
+                run = bins[bin];
+                bins[bin] = nullptr;
+                Merge(run, newer, less);
+            }
+        }
+    } catch (...) {
+        chain = Concat(run, chain);
+        for (std::size_t bin = 0; bin < used; ++bin) {
+            chain = Concat(bins[bin], chain);
+        }
+        throw;
+    }
+    chain = run;
+}
+
+// Builds the result through a pointer to the link to fill, so no dummy node is needed.
+template <typename Node, typename Links>
+template <typename Less>
+void ChainSort<Node, Links>::Merge(Node*& lhs, Node* rhs, Less& less) {
+    Node* merged = nullptr;
+    Node** tail = &merged;
+    Node* left = lhs;
+    Lookahead lhs_ahead(left);
+    Lookahead rhs_ahead(rhs);
+    try {
+        while (left != nullptr && rhs != nullptr) {
+            if (less(rhs, left)) {
+                *tail = rhs;
+                rhs = Links::Next(rhs);
+                rhs_ahead.Advance();
+            } else {
+                *tail = left;
+                left = Links::Next(left);
+                lhs_ahead.Advance();
+            }
+            tail = &Links::Next(*tail);
+        }
+    } catch (...) {
+        *tail = left;
+        lhs = Concat(rhs, merged);
+        throw;
+    }
+    *tail = left != nullptr ? left : rhs;
+    lhs = merged;
+}
+
+}  // namespace task
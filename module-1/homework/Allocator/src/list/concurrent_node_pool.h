@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace task {
+
+// Node storage shared by the concurrent queues. Nodes are carved from batches that come from the
+// allocator under a mutex (a Pool is not thread-safe) and are recycled instead of being returned
+// one by one; the batches go back to the allocator with the pool.
+//
+// Recycling is guarded by hazard pointers: a node leaves a queue through Retire and is reused only
+// once no thread holds it in a hazard slot, which keeps the queues' CASes free of ABA. Every
+// operation runs under a Guard that owns one hazard record, and the record also carries a private
+// free list and retired list, so the common path needs no atomics beyond the hazard slots. Free
+// nodes move between threads as whole lists through a shared stack that is only ever pushed to or
+// emptied in one exchange, neither of which can suffer ABA.
+//
+// Node must have a `std::atomic<Node*> next` member, which links free nodes, and a `Node*
+// retired_next` member, which links retired ones. The two are kept apart because a retired node
+// can still be protected by a thread that is about to read or CAS its `next`.
+template <typename Node, typename Allocator>
+class ConcurrentNodePool {
+    static constexpr std::size_t kSlotsPerRecord = 2;
+
+    // On a cache line of its own, so that two threads' records never share one. The allocator
+    // may only guarantee max_align_t (a Pool does), so each record is placed on the first line
+    // boundary inside a slightly larger allocation, which `storage` points back to.
+    struct alignas(64) HazardRecord {
+        std::atomic<Node*> slots[kSlotsPerRecord] = {};
+        HazardRecord* next = nullptr;
+        unsigned char* storage = nullptr;
+        // Touched only by the thread that holds the record.
+        Node* free = nullptr;
+        Node* retired = nullptr;
+        std::size_t retired_count = 0;
+        std::atomic<bool> active{true};
+    };
+    static_assert(alignof(HazardRecord) == 64 && sizeof(HazardRecord) == 64,
+                  "a hazard record must fill exactly one cache line");
+
+    struct Batch {
+        Node* nodes;
+        std::size_t size;
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+    using ByteAllocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<unsigned char>;
+    using ByteTraits = std::allocator_traits<ByteAllocator>;
+    using BatchAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Batch>;
+
+public:
+    // The calling thread's hazard record for the duration of one queue operation.
+    class Guard {
+    public:
+        explicit Guard(ConcurrentNodePool& pool) : record_(pool.AcquireRecord()) {
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            for (std::atomic<Node*>& slot : record_->slots) {
+                slot.store(nullptr, std::memory_order_release);
+            }
+            record_->active.store(false, std::memory_order_release);
+        }
+
+        // Publishes the node `source` points to in `slot` and returns it once `source` is seen to
+        // still point there, so the node cannot be recycled until the slot is reset.
+        Node* Protect(std::size_t slot, const std::atomic<Node*>& source) noexcept {
+            Node* node = source.load(std::memory_order_relaxed);
+            for (;;) {
+                record_->slots[slot].store(node, std::memory_order_seq_cst);
+                Node* current = source.load(std::memory_order_seq_cst);
+                if (current == node) {
+                    return node;
+                }
+                node = current;
+            }
+        }
+
+        // Publishes `node` without validation; the caller re-checks the link it came from.
+        void Set(std::size_t slot, Node* node) noexcept {
+            record_->slots[slot].store(node, std::memory_order_seq_cst);
+        }
+
+        void Reset(std::size_t slot) noexcept {
+            record_->slots[slot].store(nullptr, std::memory_order_release);
+        }
+
+    private:
+        friend class ConcurrentNodePool;
+
+        HazardRecord* record_;
+    };
+
+    explicit ConcurrentNodePool(const Allocator& alloc)
+        : node_alloc_(alloc), record_alloc_(alloc), batches_(BatchAllocator(alloc)), id_(NextId()) {
+    }
+
+    ConcurrentNodePool(const ConcurrentNodePool&) = delete;
+    ConcurrentNodePool& operator=(const ConcurrentNodePool&) = delete;
+
+    // No thread may be inside an operation. Values still held by nodes are the owner's business.
+    ~ConcurrentNodePool() {
+        for (const Batch& batch : batches_) {
+            for (std::size_t i = 0; i < batch.size; ++i) {
+                NodeTraits::destroy(node_alloc_, batch.nodes + i);
+            }
+            NodeTraits::deallocate(node_alloc_, batch.nodes, batch.size);
+        }
+        HazardRecord* record = records_.load(std::memory_order_relaxed);
+        while (record != nullptr) {
+            HazardRecord* next = record->next;
+            unsigned char* storage = record->storage;
+            record->~HazardRecord();
+            ByteTraits::deallocate(record_alloc_, storage, kRecordBytes);
+            record = next;
+        }
+    }
+
+    // Returns a node whose `next` is unspecified: from the record's own free list, else by taking
+    // the whole shared free stack, else from a new batch.
+    Node* Allocate(Guard& guard) {
+        HazardRecord* record = guard.record_;
+        if (record->free == nullptr) {
+            record->free = free_.exchange(nullptr, std::memory_order_acquire);
+            if (record->free == nullptr) {
+                record->free = AllocateBatch();
+            }
+        }
+        Node* node = record->free;
+        record->free = node->next.load(std::memory_order_relaxed);
+        return node;
+    }
+
+    // Returns a node from Allocate that was never published, e.g. because constructing its value
+    // threw. It goes straight back on the record's free list.
+    void Deallocate(Guard& guard, Node* node) noexcept {
+        HazardRecord* record = guard.record_;
+        node->next.store(record->free, std::memory_order_relaxed);
+        record->free = node;
+    }
+
+    // Takes back a node that is no longer reachable from any shared structure; it is reused once
+    // no hazard slot holds it. The store that unlinked it must be seq_cst, so that it is ordered
+    // against the validating load in Guard::Protect. Its `next` is left alone until then.
+    void Retire(Guard& guard, Node* node) {
+        HazardRecord* record = guard.record_;
+        node->retired_next = record->retired;
+        record->retired = node;
+        if (++record->retired_count >=
+            kReclaimThreshold + kSlotsPerRecord * record_count_.load(std::memory_order_relaxed)) {
+            Reclaim(record);
+        }
+    }
+
+private:
+    static constexpr std::size_t kMinBatchNodes = 64;
+    static constexpr std::size_t kReclaimThreshold = 64;
+    static constexpr std::size_t kRecordBytes = sizeof(HazardRecord) + alignof(HazardRecord) - 1;
+
+    // Each thread remembers the record it used last, keyed by a pool id that is never reused, so
+    // a hint left over from a destroyed pool cannot match.
+    struct RecordHint {
+        std::uint64_t pool_id = 0;
+        HazardRecord* record = nullptr;
+    };
+
+    static std::uint64_t NextId() noexcept {
+        static std::atomic<std::uint64_t> next_id{1};
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool TryClaim(HazardRecord* record) noexcept {
+        return !record->active.load(std::memory_order_relaxed) &&
+               !record->active.exchange(true, std::memory_order_acquire);
+    }
+
+    HazardRecord* AcquireRecord() {
+        static thread_local RecordHint hint;
+        if (hint.pool_id == id_ && TryClaim(hint.record)) {
+            return hint.record;
+        }
+        HazardRecord* head = records_.load(std::memory_order_acquire);
+        for (HazardRecord* record = head; record != nullptr; record = record->next) {
+            if (TryClaim(record)) {
+                hint = {id_, record};
+                return record;
+            }
+        }
+        unsigned char* storage;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            storage = ByteTraits::allocate(record_alloc_, kRecordBytes);
+        }
+        void* aligned = storage;
+        std::size_t space = kRecordBytes;
+        std::align(alignof(HazardRecord), sizeof(HazardRecord), aligned, space);
+        auto* record = ::new (aligned) HazardRecord;
+        record->storage = storage;
+        // Records are only ever prepended and live as long as the pool.
+        record->next = head;
+        while (!records_.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        }
+        record_count_.fetch_add(1, std::memory_order_relaxed);
+        hint = {id_, record};
+        return record;
+    }
+
+    bool IsProtected(const Node* node) const noexcept {
+        for (HazardRecord* record = records_.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            for (const std::atomic<Node*>& slot : record->slots) {
+                if (slot.load(std::memory_order_seq_cst) == node) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Keeps the record's protected retired nodes and publishes the rest on the shared free stack.
+    // Only the unprotected ones have their `next` overwritten.
+    void Reclaim(HazardRecord* record) {
+        Node* kept = nullptr;
+        Node* freed_first = nullptr;
+        Node* freed_last = nullptr;
+        std::size_t kept_count = 0;
+        for (Node* node = record->retired; node != nullptr;) {
+            Node* next = node->retired_next;
+            if (IsProtected(node)) {
+                node->retired_next = kept;
+                kept = node;
+                ++kept_count;
+            } else {
+                node->next.store(freed_first, std::memory_order_relaxed);
+                freed_last = freed_first == nullptr ? node : freed_last;
+                freed_first = node;
+            }
+            node = next;
+        }
+        record->retired = kept;
+        record->retired_count = kept_count;
+        if (freed_first != nullptr) {
+            Node* top = free_.load(std::memory_order_relaxed);
+            do {
+                freed_last->next.store(top, std::memory_order_relaxed);
+            } while (!free_.compare_exchange_weak(top, freed_first, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+    }
+
+    // Slow path: one allocation for a batch that grows with the pool, like task::list's slabs.
+    // Returns the batch's nodes linked through `next`.
+    Node* AllocateBatch() {
+        Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.size = std::max(kMinBatchNodes, node_count_);
+            // Room first, so that recording the batch cannot throw after it is allocated.
+            batches_.reserve(batches_.size() + 1);
+            batch.nodes = NodeTraits::allocate(node_alloc_, batch.size);
+            batches_.push_back(batch);
+            node_count_ += batch.size;
+        }
+        for (std::size_t i = 0; i < batch.size; ++i) {
+            NodeTraits::construct(node_alloc_, batch.nodes + i);
+            if (i > 0) {
+                batch.nodes[i - 1].next.store(batch.nodes + i, std::memory_order_relaxed);
+            }
+        }
+        return batch.nodes;
+    }
+
+    NodeAllocator node_alloc_;
+    ByteAllocator record_alloc_;
+    std::vector<Batch, BatchAllocator> batches_;
+    const std::uint64_t id_;
+    std::mutex mutex_;
+    std::size_t node_count_ = 0;
+
+    alignas(64) std::atomic<Node*> free_{nullptr};
+    alignas(64) std::atomic<HazardRecord*> records_{nullptr};
+    std::atomic<std::size_t> record_count_{0};
+};
+
+}  // namespace task
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "concurrent_node_pool.h"
+
+namespace task {
+
+template <typename T>
+struct ConcurrentQueueNode {
+    std::atomic<ConcurrentQueueNode*> next{nullptr};
+    ConcurrentQueueNode* retired_next = nullptr;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* Value() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+};
+
+// Unbounded multi-producer multi-consumer FIFO (Michael & Scott): Push and TryPop are lock-free
+// and may be called from any number of threads. Nodes come from a ConcurrentNodePool, so the
+// allocator is only touched, under a mutex, when the pool runs dry; it must not be used elsewhere
+// concurrently. The pool keeps nodes until the queue is destroyed.
+template <typename T, typename Allocator = std::allocator<T>>
+class MpmcQueue {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "a value taken off the queue must not be lost to a throwing move");
+
+    using Node = ConcurrentQueueNode<T>;
+    using Pool = ConcurrentNodePool<Node, Allocator>;
+    using Guard = typename Pool::Guard;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    MpmcQueue() : MpmcQueue(Allocator()) {
+    }
+    explicit MpmcQueue(const Allocator& alloc) : alloc_(alloc), pool_(alloc) {
+        Guard guard(pool_);
+        Node* dummy = pool_.Allocate(guard);
+        dummy->next.store(nullptr, std::memory_order_relaxed);
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Destroys the values still queued. No other thread may be using the queue.
+    ~MpmcQueue() {
+        Node* node = head_.load(std::memory_order_relaxed)->next.load(std::memory_order_relaxed);
+        for (; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+            std::allocator_traits<Allocator>::destroy(alloc_, node->Value());
+        }
+    }
+
+    void Push(const T& value) {
+        Emplace(value);
+    }
+    void Push(T&& value) {
+        Emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    void Emplace(Args&&... args);
+
+    // Returns the oldest value, or nothing if the queue was empty at some point during the call.
+    std::optional<T> TryPop();
+
+    // A snapshot that may be stale by the time it is used.
+    bool Empty() const noexcept {
+        Node* head = head_.load(std::memory_order_acquire);
+        return head == tail_.load(std::memory_order_acquire) &&
+               head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    Allocator alloc_;
+    Pool pool_;
+    // On separate lines so that producers and consumers do not invalidate each other.
+    alignas(64) std::atomic<Node*> head_{nullptr};
+    alignas(64) std::atomic<Node*> tail_{nullptr};
+};
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void MpmcQueue<T, Allocator>::Emplace(Args&&... args) {
+    Guard guard(pool_);
+    Node* node = pool_.Allocate(guard);
+    try {
+        std::allocator_traits<Allocator>::construct(alloc_, node->Value(),
+                                                    std::forward<Args>(args)...);
+    } catch (...) {
+        pool_.Deallocate(guard, node);
+        throw;
+    }
+    node->next.store(nullptr, std::memory_order_relaxed);
+
+    for (;;) {
+        Node* tail = guard.Protect(0, tail_);
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail != tail_.load(std::memory_order_acquire)) {
+            continue;
+        }
+        if (next != nullptr) {
+            // Another producer linked its node but has not swung the tail yet; help it along.
+            tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                        std::memory_order_relaxed);
+            continue;
+        }
+        if (tail->next.compare_exchange_weak(next, node, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+            tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                          std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+// The old head is a dummy whose value was taken earlier; its successor becomes the new dummy once
+// the winning consumer has moved the value out of it (slot 1 keeps it alive meanwhile).
+template <typename T, typename Allocator>
+std::optional<T> MpmcQueue<T, Allocator>::TryPop() {
+    Guard guard(pool_);
+    for (;;) {
+        Node* head = guard.Protect(0, head_);
+        Node* next = head->next.load(std::memory_order_acquire);
+        guard.Set(1, next);
+        if (head != head_.load(std::memory_order_seq_cst)) {
+            continue;
+        }
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+        Node* tail = tail_.load(std::memory_order_acquire);
+        if (head == tail) {
+            tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                        std::memory_order_relaxed);
+            continue;
+        }
+        if (head_.compare_exchange_weak(head, next, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+            std::optional<T> value(std::move(*next->Value()));
+            std::allocator_traits<Allocator>::destroy(alloc_, next->Value());
+            pool_.Retire(guard, head);
+            return value;
+        }
+    }
+}
+
+// Unbounded multi-producer single-consumer FIFO (Vyukov): Push is one exchange on the tail plus a
+// store, with no retry loop, and TryPop never contends with producers. Only one thread at a time
+// may call TryPop. A producer that is preempted between its exchange and its store hides the
+// values pushed after it until it resumes, so TryPop can report empty while Push calls that
+// completed later are still in flight. Nodes are recycled through the same pool as MpmcQueue.
+template <typename T, typename Allocator = std::allocator<T>>
+class MpscQueue {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "a value taken off the queue must not be lost to a throwing move");
+
+    using Node = ConcurrentQueueNode<T>;
+    using Pool = ConcurrentNodePool<Node, Allocator>;
+    using Guard = typename Pool::Guard;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    MpscQueue() : MpscQueue(Allocator()) {
+    }
+    explicit MpscQueue(const Allocator& alloc) : alloc_(alloc), pool_(alloc) {
+        Guard guard(pool_);
+        head_ = pool_.Allocate(guard);
+        head_->next.store(nullptr, std::memory_order_relaxed);
+        tail_.store(head_, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Destroys the values still queued. No other thread may be using the queue.
+    ~MpscQueue() {
+        Node* node = head_->next.load(std::memory_order_relaxed);
+        for (; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+            std::allocator_traits<Allocator>::destroy(alloc_, node->Value());
+        }
+    }
+
+    void Push(const T& value) {
+        Emplace(value);
+    }
+    void Push(T&& value) {
+        Emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    void Emplace(Args&&... args) {
+        Guard guard(pool_);
+        Node* node = pool_.Allocate(guard);
+        try {
+            std::allocator_traits<Allocator>::construct(alloc_, node->Value(),
+                                                        std::forward<Args>(args)...);
+        } catch (...) {
+            pool_.Deallocate(guard, node);
+            throw;
+        }
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = tail_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer only. The old head cannot still be used by a producer: its `next` is set, and
+    // setting it is the last thing a producer does with its predecessor.
+    std::optional<T> TryPop() {
+        Node* next = head_->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(*next->Value()));
+        std::allocator_traits<Allocator>::destroy(alloc_, next->Value());
+        Guard guard(pool_);
+        pool_.Retire(guard, head_);
+        head_ = next;
+        return value;
+    }
+
+    // Consumer only.
+    bool Empty() const noexcept {
+        return head_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    Allocator alloc_;
+    Pool pool_;
+    alignas(64) Node* head_ = nullptr;
+    alignas(64) std::atomic<Node*> tail_{nullptr};
+};
+
+}  // namespace task
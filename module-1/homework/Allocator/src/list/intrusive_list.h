@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "chain_sort.h"
+
+namespace task {
+
+template <typename T, typename Tag>
+class IntrusiveList;
+
+// Base class that makes T linkable into an IntrusiveList<T, Tag>. An object can sit on several
+// lists at once by deriving from one hook per Tag. Copying an object does not copy its membership.
+template <typename Tag = void>
+class IntrusiveListHook {
+public:
+    IntrusiveListHook() = default;
+    IntrusiveListHook(const IntrusiveListHook&) noexcept {
+    }
+    IntrusiveListHook& operator=(const IntrusiveListHook&) noexcept {
+        return *this;
+    }
+    ~IntrusiveListHook() {
+        assert(!IsLinked() && "object destroyed while still on an IntrusiveList");
+    }
+
+    bool IsLinked() const noexcept {
+        return next_ != nullptr;
+    }
+
+private:
+    template <typename, typename>
+    friend class IntrusiveList;
+
+    IntrusiveListHook* prev_ = nullptr;
+    IntrusiveListHook* next_ = nullptr;
+};
+
+// Doubly linked list of objects that embed an IntrusiveListHook<Tag>. The list never allocates,
+// copies or destroys elements: it only links their hooks, so the objects must outlive their
+// membership. Mirrors task::List's interface where it makes sense for non-owning links.
+template <typename T, typename Tag = void>
+class IntrusiveList {
+    using Hook = IntrusiveListHook<Tag>;
+    static_assert(std::is_base_of_v<Hook, T>, "T must derive from IntrusiveListHook<Tag>");
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        Iterator(const Iterator<WasConst>& other) noexcept  // NOLINT
+            : hook_(other.hook_) {
+        }
+
+        reference operator*() const noexcept {
+            return *static_cast<pointer>(hook_);
+        }
+        pointer operator->() const noexcept {
+            return static_cast<pointer>(hook_);
+        }
+
+        Iterator& operator++() noexcept {
+            hook_ = hook_->next_;
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+        Iterator& operator--() noexcept {
+            hook_ = hook_->prev_;
+            return *this;
+        }
+        Iterator operator--(int) noexcept {
+            Iterator copy(*this);
+            --*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.hook_ == rhs.hook_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.hook_ != rhs.hook_;
+        }
+
+    private:
+        friend class IntrusiveList;
+
+        using HookPtr = std::conditional_t<IsConst, const Hook*, Hook*>;
+
+        explicit Iterator(HookPtr hook) noexcept : hook_(hook) {
+        }
+
+        HookPtr hook_ = nullptr;
+    };
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // Special member functions
+    IntrusiveList() noexcept {
+        ResetHead();
+    }
+
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    IntrusiveList(IntrusiveList&& other) noexcept {
+        ResetHead();
+        Splice(End(), other);
+    }
+    IntrusiveList& operator=(IntrusiveList&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            Splice(End(), other);
+        }
+        return *this;
+    }
+
+    // Unlinks every element; the elements themselves are untouched.
+    ~IntrusiveList() {
+        Clear();
+        head_.prev_ = nullptr;
+        head_.next_ = nullptr;
+    }
+
+    // Element access
+    reference Front() noexcept {
+        return *Begin();
+    }
+    const_reference Front() const noexcept {
+        return *Begin();
+    }
+    reference Back() noexcept {
+        return *std::prev(End());
+    }
+    const_reference Back() const noexcept {
+        return *std::prev(End());
+    }
+
+    // Iterators
+    iterator Begin() noexcept {
+        return iterator(head_.next_);
+    }
+    const_iterator Begin() const noexcept {
+        return const_iterator(head_.next_);
+    }
+    iterator End() noexcept {
+        return iterator(&head_);
+    }
+    const_iterator End() const noexcept {
+        return const_iterator(&head_);
+    }
+
+    // Iterator to an element known to be on this list, in O(1).
+    static iterator IteratorTo(T& value) noexcept {
+        return iterator(static_cast<Hook*>(std::addressof(value)));
+    }
+    static const_iterator IteratorTo(const T& value) noexcept {
+        return const_iterator(static_cast<const Hook*>(std::addressof(value)));
+    }
+
+    // Capacity
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+    size_type Size() const noexcept {
+        return size_;
+    }
+
+    // Modifiers
+    void Clear() noexcept;
+    void Swap(IntrusiveList& other) noexcept;
+
+    void PushBack(T& value) noexcept {
+        Insert(End(), value);
+    }
+    void PushFront(T& value) noexcept {
+        Insert(Begin(), value);
+    }
+    void PopBack() noexcept {
+        Erase(std::prev(End()));
+    }
+    void PopFront() noexcept {
+        Erase(Begin());
+    }
+
+    // `value` must not be on a list with the same Tag already.
+    iterator Insert(const_iterator pos, T& value) noexcept;
+    iterator Erase(const_iterator pos) noexcept;
+    iterator Erase(const_iterator first, const_iterator last) noexcept;
+
+    // Operations
+    void Splice(const_iterator pos, IntrusiveList& other) noexcept;
+    void Splice(const_iterator pos, IntrusiveList& other, const_iterator it) noexcept;
+    void Splice(const_iterator pos, IntrusiveList& other, const_iterator first,
+                const_iterator last) noexcept;
+
+    void Sort() {
+        Sort(std::less<>());
+    }
+    template <typename Compare>
+    void Sort(Compare comp);
+
+private:
+    static Hook* MutableHook(const_iterator pos) noexcept {
+        return pos.hook_->prev_->next_;
+    }
+    static const T& ValueOf(const Hook* hook) noexcept {
+        return *static_cast<const T*>(hook);
+    }
+    static void Unlink(Hook* hook) noexcept;
+    static void Transfer(Hook* pos, Hook* first, Hook* last) noexcept;
+
+    struct HookLinks {
+        static Hook*& Next(Hook* hook) noexcept {
+            return hook->next_;
+        }
+    };
+    using Sorter = ChainSort<Hook, HookLinks>;
+
+    void Relink(Hook* first) noexcept;
+
+    void ResetHead() noexcept {
+        head_.prev_ = &head_;
+        head_.next_ = &head_;
+        size_ = 0;
+    }
+
+    Hook head_;
+    size_type size_ = 0;
+};
+
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Clear() noexcept {
+    Hook* hook = head_.next_;
+    while (hook != &head_) {
+        Hook* next = hook->next_;
+        hook->prev_ = nullptr;
+        hook->next_ = nullptr;
+        hook = next;
+    }
+    ResetHead();
+}
+
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Swap(IntrusiveList& other) noexcept {
+    IntrusiveList tmp(std::move(other));
+    other.Splice(other.End(), *this);
+    Splice(End(), tmp);
+}
+
+template <typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::Insert(const_iterator pos,
+                                                                       T& value) noexcept {
+    Hook* hook = static_cast<Hook*>(std::addressof(value));
+    assert(!hook->IsLinked());
+    Hook* next = MutableHook(pos);
+    hook->next_ = next;
+    hook->prev_ = next->prev_;
+    next->prev_->next_ = hook;
+    next->prev_ = hook;
+    ++size_;
+    return iterator(hook);
+}
+
+template <typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::Erase(
+    const_iterator pos) noexcept {
+    Hook* hook = MutableHook(pos);
+    Hook* next = hook->next_;
+    Unlink(hook);
+    --size_;
+    return iterator(next);
+}
+
+template <typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::Erase(
+    const_iterator first, const_iterator last) noexcept {
+    Hook* hook = MutableHook(first);
+    Hook* end = MutableHook(last);
+    while (hook != end) {
+        Hook* next = hook->next_;
+        Unlink(hook);
+        --size_;
+        hook = next;
+    }
+    return iterator(end);
+}
+
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Splice(const_iterator pos, IntrusiveList& other) noexcept {
+    if (this == &other || other.Empty()) {
+        return;
+    }
+    Transfer(MutableHook(pos), other.head_.next_, &other.head_);
+    size_ += other.size_;
+    other.size_ = 0;
+}
+
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Splice(const_iterator pos, IntrusiveList& other,
+                                   const_iterator it) noexcept {
+    Hook* hook = MutableHook(it);
+    Hook* target = MutableHook(pos);
+    if (target == hook || target == hook->next_) {
+        return;
+    }
+    Transfer(target, hook, hook->next_);
+    ++size_;
+    --other.size_;
+}
+
+// O(1) within one list; between lists the range is walked once to keep Size() constant-time.
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Splice(const_iterator pos, IntrusiveList& other, const_iterator first,
+                                   const_iterator last) noexcept {
+    if (this != &other) {
+        size_type count = static_cast<size_type>(std::distance(first, last));
+        size_ += count;
+        other.size_ -= count;
+    }
+    Transfer(MutableHook(pos), MutableHook(first), MutableHook(last));
+}
+
+// The same bottom-up natural merge sort as List::Sort: stable, only relinks hooks and is O(n) on
+// sorted input. If `comp` throws, every element is still on the list, in unspecified order.
+template <typename T, typename Tag>
+template <typename Compare>
+void IntrusiveList<T, Tag>::Sort(Compare comp) {
+    if (size_ < 2) {
+        return;
+    }
+    auto less = [&comp](const Hook* lhs, const Hook* rhs) {
+        return comp(ValueOf(lhs), ValueOf(rhs));
+    };
+    head_.prev_->next_ = nullptr;
+    Hook* chain = head_.next_;
+    try {
+        Sorter::Sort(chain, less);
+    } catch (...) {
+        Relink(chain);
+        throw;
+    }
+    Relink(chain);
+}
+
+// Re-attaches a null-terminated chain to the sentinel and restores the `prev_` links.
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Relink(Hook* first) noexcept {
+    Hook* prev = &head_;
+    for (Hook* hook = first; hook != nullptr; hook = hook->next_) {
+        hook->prev_ = prev;
+        prev->next_ = hook;
+        prev = hook;
+    }
+    prev->next_ = &head_;
+    head_.prev_ = prev;
+}
+
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Unlink(Hook* hook) noexcept {
+    hook->prev_->next_ = hook->next_;
+    hook->next_->prev_ = hook->prev_;
+    hook->prev_ = nullptr;
+    hook->next_ = nullptr;
+}
+
+// Relinks [first, last) before `pos`; the range must not contain `pos`.
+template <typename T, typename Tag>
+void IntrusiveList<T, Tag>::Transfer(Hook* pos, Hook* first, Hook* last) noexcept {
+    if (first == last) {
+        return;
+    }
+    Hook* last_hook = last->prev_;
+    first->prev_->next_ = last;
+    last->prev_ = first->prev_;
+
+    last_hook->next_ = pos;
+    first->prev_ = pos->prev_;
+    pos->prev_->next_ = first;
+    pos->prev_ = last_hook;
+}
+
+}  // namespace task
@@ -1,34 +1,163 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <list>
 #include <memory>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "chain_sort.h"
+#include "open_addressing_set.h"
+#include "prefetch.h"
 
 namespace task {
 
 template <typename T, typename Allocator = std::allocator<T>>
 class List {
+    struct NodeBase {
+        NodeBase* prev;
+        NodeBase* next;
+    };
+
+    struct Node : NodeBase {
+        T value;
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+    // Runs kPrefetchDistance nodes ahead of a walk along `next` links and prefetches each node it
+    // reaches, so the walk finds them in flight. Stops at `end`: the sentinel or nullptr.
+    class Lookahead {
+    public:
+        Lookahead(const NodeBase* first, const NodeBase* end) noexcept : node_(first), end_(end) {
+            for (std::size_t i = 0; i < kPrefetchDistance; ++i) {
+                Advance();
+            }
+        }
+
+        void Advance() noexcept {
+            if (kPrefetchDistance > 0 && node_ != end_) {
+                node_ = node_->next;
+                Prefetch(node_);
+            }
+        }
+
+        // Must be called before `node` is unlinked.
+        void Leave(const NodeBase* node) noexcept {
+            if (node_ == node) {
+                Advance();
+            }
+        }
+
+    private:
+        const NodeBase* node_;
+        const NodeBase* end_;
+    };
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        Iterator(const Iterator<WasConst>& other) noexcept  // NOLINT
+            : node_(other.node_) {
+        }
+
+        reference operator*() const noexcept {
+            return static_cast<NodePtr>(node_)->value;
+        }
+        pointer operator->() const noexcept {
+            return std::addressof(static_cast<NodePtr>(node_)->value);
+        }
+
+        Iterator& operator++() noexcept {
+            node_ = node_->next;
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+        Iterator& operator--() noexcept {
+            node_ = node_->prev;
+            return *this;
+        }
+        Iterator operator--(int) noexcept {
+            Iterator copy(*this);
+            --*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.node_ == rhs.node_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.node_ != rhs.node_;
+        }
+
+    private:
+        friend class List;
+
+        using BasePtr = std::conditional_t<IsConst, const NodeBase*, NodeBase*>;
+        using NodePtr = std::conditional_t<IsConst, const Node*, Node*>;
+
+        explicit Iterator(BasePtr node) noexcept : node_(node) {
+        }
+
+        BasePtr node_ = nullptr;
+    };
 
 public:
     using value_type = T;
-    // Your code goes here
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    // Special member functions
-    List(){};
+    // ParallelSort falls back to Sort below this many elements.
+    static constexpr size_type kParallelSortThreshold = size_type{1} << 16;
 
-    List(const List& other) {
-        // Your code goes here
+    // Special member functions
+    List() : List(Allocator()) {
     }
+    explicit List(const Allocator& alloc);
+
+    List(const List& other);
     List(const List& other, const Allocator& alloc);
 
-    List(List&& other);
+    List(List&& other) noexcept;
     List(List&& other, const Allocator& alloc);
 
     ~List();
 
     List& operator=(const List& other);
 
-    List& operator=(List&& other) noexcept;
+    List& operator=(List&& other) noexcept(
+        NodeTraits::propagate_on_container_move_assignment::value ||
+        NodeTraits::is_always_equal::value);
 
     // Element access
     reference Front();
@@ -55,7 +184,7 @@ public:
 
     void PushBack(const T& value);
     void PushBack(T&& value);
-    
+
     template <typename... Args>
     void EmplaceBack(Args&&... args);
     void PopBack();
@@ -66,16 +195,847 @@ public:
     void PopFront();
 
     void Resize(size_type count);
+    void Resize(size_type count, const value_type& value);
+
+    iterator Insert(const_iterator pos, const T& value);
+    iterator Insert(const_iterator pos, T&& value);
+    iterator Insert(const_iterator pos, size_type count, const T& value);
+    template <typename InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last);
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args);
+
+    iterator Erase(const_iterator pos);
+    iterator Erase(const_iterator first, const_iterator last);
 
     // Operations
+    void Splice(const_iterator pos, List& other);
+    void Splice(const_iterator pos, List&& other);
+    void Splice(const_iterator pos, List& other, const_iterator it);
+    void Splice(const_iterator pos, List&& other, const_iterator it);
+    void Splice(const_iterator pos, List& other, const_iterator first, const_iterator last);
+    void Splice(const_iterator pos, List&& other, const_iterator first, const_iterator last);
+
+    void Merge(List& other);
+    void Merge(List&& other);
+    template <typename Compare>
+    void Merge(List& other, Compare comp);
+    template <typename Compare>
+    void Merge(List&& other, Compare comp);
+
     void Remove(const T& value);
+    template <typename Predicate>
+    size_type RemoveIf(Predicate pred);
     void Unique();
+    // Keeps the first occurrence of every value, preserving order; returns how many were removed.
+    template <typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    size_type RemoveDuplicates(const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual());
     void Sort();
+    void ParallelSort(std::size_t max_threads = std::thread::hardware_concurrency());
+
+    // Moves the elements into fresh nodes laid out in ascending address order, so that a
+    // long-lived, scattered list is scanned front to back through memory again.
+    void Compact();
 
     allocator_type GetAllocator() const noexcept;
 
 private:
-    // Your code goes here
+    template <typename... Args>
+    Node* CreateNode(Args&&... args);
+    void DestroyNode(NodeBase* node) noexcept;
+    void DestroyChain(NodeBase* first) noexcept;
+
+    template <typename... Args>
+    NodeBase* EmplaceBefore(NodeBase* pos, Args&&... args);
+    void Erase(NodeBase* node) noexcept;
+
+    static NodeBase* MutableNode(const_iterator pos) noexcept;
+    static void LinkBefore(NodeBase* pos, NodeBase* node) noexcept;
+    static void Unlink(NodeBase* node) noexcept;
+    static void Transfer(NodeBase* pos, NodeBase* first, NodeBase* last) noexcept;
+
+    void ResetHead() noexcept;
+    void StealNodes(List& other) noexcept;
+    void MoveElements(List& other);
+    template <typename Iter>
+    void AssignRange(Iter first, Iter last);
+
+    struct NodeLinks {
+        static NodeBase*& Next(NodeBase* node) noexcept {
+            return node->next;
+        }
+    };
+    using Sorter = ChainSort<NodeBase, NodeLinks>;
+
+    // Orders nodes by value with std::less<>.
+    struct NodeLess {
+        bool operator()(const NodeBase* lhs, const NodeBase* rhs) const {
+            return std::less<>()(static_cast<const Node*>(lhs)->value,
+                                 static_cast<const Node*>(rhs)->value);
+        }
+    };
+
+    void RelinkSorted(NodeBase* first) noexcept;
+
+    NodeBase head_;
+    size_type size_ = 0;
+    NodeAllocator alloc_;
 };
 
-}  // namespace task
\ No newline at end of file
+// Special member functions
+template <typename T, typename Allocator>
+List<T, Allocator>::List(const Allocator& alloc) : alloc_(alloc) {
+    ResetHead();
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>::List(const List& other)
+    : List(other, Allocator(NodeTraits::select_on_container_copy_construction(other.alloc_))) {
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>::List(const List& other, const Allocator& alloc) : List(alloc) {
+    AssignRange(other.Begin(), other.End());
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>::List(List&& other) noexcept : alloc_(std::move(other.alloc_)) {
+    ResetHead();
+    StealNodes(other);
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>::List(List&& other, const Allocator& alloc) : List(alloc) {
+    if (NodeTraits::is_always_equal::value || alloc_ == other.alloc_) {
+        StealNodes(other);
+    } else {
+        MoveElements(other);
+    }
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>::~List() {
+    Clear();
+}
+
+template <typename T, typename Allocator>
+List<T, Allocator>& List<T, Allocator>::operator=(const List& other) {
+    if (this == &other) {
+        return *this;
+    }
+    if constexpr (NodeTraits::propagate_on_container_copy_assignment::value) {
+        // Nodes must go back to the allocator that produced them.
+        if (!NodeTraits::is_always_equal::value && alloc_ != other.alloc_) {
+            Clear();
+        }
+        alloc_ = other.alloc_;
+    }
+    AssignRange(other.Begin(), other.End());
+    return *this;
+}
+
+// O(1) when the allocator propagates or the allocators are equal; otherwise the nodes cannot be
+// adopted and the elements are moved one by one into nodes from our allocator.
+template <typename T, typename Allocator>
+List<T, Allocator>& List<T, Allocator>::operator=(List&& other) noexcept(
+    NodeTraits::propagate_on_container_move_assignment::value ||
+    NodeTraits::is_always_equal::value) {
+    if (this == &other) {
+        return *this;
+    }
+    if constexpr (NodeTraits::propagate_on_container_move_assignment::value) {
+        Clear();
+        alloc_ = std::move(other.alloc_);
+        StealNodes(other);
+    } else {
+        if (NodeTraits::is_always_equal::value || alloc_ == other.alloc_) {
+            Clear();
+            StealNodes(other);
+        } else {
+            AssignRange(std::make_move_iterator(other.Begin()),
+                        std::make_move_iterator(other.End()));
+            other.Clear();
+        }
+    }
+    return *this;
+}
+
+// Element access
+template <typename T, typename Allocator>
+typename List<T, Allocator>::reference List<T, Allocator>::Front() {
+    return static_cast<Node*>(head_.next)->value;
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::const_reference List<T, Allocator>::Front() const {
+    return static_cast<const Node*>(head_.next)->value;
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::reference List<T, Allocator>::Back() {
+    return static_cast<Node*>(head_.prev)->value;
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::const_reference List<T, Allocator>::Back() const {
+    return static_cast<const Node*>(head_.prev)->value;
+}
+
+// Iterators
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Begin() noexcept {
+    return iterator(head_.next);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::const_iterator List<T, Allocator>::Begin() const noexcept {
+    return const_iterator(head_.next);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::End() noexcept {
+    return iterator(&head_);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::const_iterator List<T, Allocator>::End() const noexcept {
+    return const_iterator(&head_);
+}
+
+// Capacity
+template <typename T, typename Allocator>
+bool List<T, Allocator>::Empty() const noexcept {
+    return size_ == 0;
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::size_type List<T, Allocator>::Size() const noexcept {
+    return size_;
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::size_type List<T, Allocator>::MaxSize() const noexcept {
+    return NodeTraits::max_size(alloc_);
+}
+
+// Modifiers
+template <typename T, typename Allocator>
+void List<T, Allocator>::Clear() {
+    NodeBase* node = head_.next;
+    while (node != &head_) {
+        NodeBase* next = node->next;
+        DestroyNode(node);
+        node = next;
+    }
+    ResetHead();
+}
+
+// Swapping nodes between unequal allocators that do not propagate is undefined, as for
+// std::list.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Swap(List& other) noexcept {
+    if constexpr (NodeTraits::propagate_on_container_swap::value) {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+    } else {
+        assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    }
+
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    for (List* list : {this, &other}) {
+        if (list->size_ == 0) {
+            list->ResetHead();
+        } else {
+            list->head_.next->prev = &list->head_;
+            list->head_.prev->next = &list->head_;
+        }
+    }
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PushBack(const T& value) {
+    EmplaceBefore(&head_, value);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PushBack(T&& value) {
+    EmplaceBefore(&head_, std::move(value));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void List<T, Allocator>::EmplaceBack(Args&&... args) {
+    EmplaceBefore(&head_, std::forward<Args>(args)...);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PopBack() {
+    Erase(head_.prev);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PushFront(const T& value) {
+    EmplaceBefore(head_.next, value);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PushFront(T&& value) {
+    EmplaceBefore(head_.next, std::move(value));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void List<T, Allocator>::EmplaceFront(Args&&... args) {
+    EmplaceBefore(head_.next, std::forward<Args>(args)...);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::PopFront() {
+    Erase(head_.next);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Resize(size_type count) {
+    while (size_ > count) {
+        PopBack();
+    }
+    while (size_ < count) {
+        EmplaceBack();
+    }
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Resize(size_type count, const value_type& value) {
+    while (size_ > count) {
+        PopBack();
+    }
+    while (size_ < count) {
+        PushBack(value);
+    }
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Insert(const_iterator pos,
+                                                                 const T& value) {
+    return iterator(EmplaceBefore(MutableNode(pos), value));
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Insert(const_iterator pos, T&& value) {
+    return iterator(EmplaceBefore(MutableNode(pos), std::move(value)));
+}
+
+// Multi-element inserts build their nodes aside and splice them in, so a throwing constructor
+// leaves the list untouched.
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Insert(const_iterator pos,
+                                                                 size_type count,
+                                                                 const T& value) {
+    List nodes(GetAllocator());
+    for (size_type i = 0; i < count; ++i) {
+        nodes.PushBack(value);
+    }
+    iterator first(nodes.Empty() ? MutableNode(pos) : nodes.head_.next);
+    Splice(pos, nodes);
+    return first;
+}
+
+template <typename T, typename Allocator>
+template <typename InputIt, typename>
+typename List<T, Allocator>::iterator List<T, Allocator>::Insert(const_iterator pos,
+                                                                 InputIt first, InputIt last) {
+    List nodes(GetAllocator());
+    for (; first != last; ++first) {
+        nodes.EmplaceBack(*first);
+    }
+    iterator result(nodes.Empty() ? MutableNode(pos) : nodes.head_.next);
+    Splice(pos, nodes);
+    return result;
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+typename List<T, Allocator>::iterator List<T, Allocator>::Emplace(const_iterator pos,
+                                                                  Args&&... args) {
+    return iterator(EmplaceBefore(MutableNode(pos), std::forward<Args>(args)...));
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Erase(const_iterator pos) {
+    NodeBase* node = MutableNode(pos);
+    NodeBase* next = node->next;
+    Erase(node);
+    return iterator(next);
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::iterator List<T, Allocator>::Erase(const_iterator first,
+                                                                const_iterator last) {
+    NodeBase* node = MutableNode(first);
+    NodeBase* end = MutableNode(last);
+    while (node != end) {
+        NodeBase* next = node->next;
+        Erase(node);
+        node = next;
+    }
+    return iterator(end);
+}
+
+// Operations
+template <typename T, typename Allocator>
+void List<T, Allocator>::Remove(const T& value) {
+    RemoveIf([&value](const T& element) { return element == value; });
+}
+
+// One pass that only unlinks; the removed nodes are destroyed together afterwards. The predicate
+// may therefore refer to an element that is being removed (as Remove's `value` may), and the
+// allocator sees one burst of deallocations rather than frees interleaved with the scan.
+template <typename T, typename Allocator>
+template <typename Predicate>
+typename List<T, Allocator>::size_type List<T, Allocator>::RemoveIf(Predicate pred) {
+    NodeBase* removed = nullptr;
+    size_type count = 0;
+    try {
+        NodeBase* node = head_.next;
+        Lookahead ahead(node, &head_);
+        while (node != &head_) {
+            NodeBase* next = node->next;
+            ahead.Advance();
+            if (pred(static_cast<Node*>(node)->value)) {
+                Unlink(node);
+                node->next = removed;
+                removed = node;
+                ++count;
+            }
+            node = next;
+        }
+    } catch (...) {
+        size_ -= count;
+        DestroyChain(removed);
+        throw;
+    }
+    size_ -= count;
+    DestroyChain(removed);
+    return count;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Unique() {
+    if (size_ < 2) {
+        return;
+    }
+    NodeBase* node = head_.next;
+    Lookahead ahead(node, &head_);
+    while (node->next != &head_) {
+        ahead.Advance();
+        if (static_cast<Node*>(node)->value == static_cast<Node*>(node->next)->value) {
+            ahead.Leave(node->next);
+            Erase(node->next);
+        } else {
+            node = node->next;
+        }
+    }
+}
+
+// Kept elements are recorded by address in an open-addressing set, so values are never copied;
+// the set's table comes from this list's allocator.
+template <typename T, typename Allocator>
+template <typename Hash, typename KeyEqual>
+typename List<T, Allocator>::size_type List<T, Allocator>::RemoveDuplicates(
+    const Hash& hash, const KeyEqual& equal) {
+    if (size_ < 2) {
+        return 0;
+    }
+    OpenAddressingSet<T, Hash, KeyEqual, NodeAllocator> seen(size_, hash, equal, alloc_);
+    return RemoveIf([&seen](const T& value) { return !seen.Insert(std::addressof(value)); });
+}
+
+// Splices only relink nodes, so both lists must share an allocator; moving nodes between unequal
+// allocators is undefined, as for std::list.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List& other) {
+    assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    if (this == &other || other.Empty()) {
+        return;
+    }
+    Transfer(MutableNode(pos), other.head_.next, &other.head_);
+    size_ += other.size_;
+    other.size_ = 0;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List&& other) {
+    Splice(pos, other);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List& other, const_iterator it) {
+    assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    NodeBase* node = MutableNode(it);
+    NodeBase* target = MutableNode(pos);
+    if (target == node || target == node->next) {
+        return;
+    }
+    Transfer(target, node, node->next);
+    ++size_;
+    --other.size_;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List&& other, const_iterator it) {
+    Splice(pos, other, it);
+}
+
+// O(1) within one list; between lists the range is walked once to keep Size() constant-time.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List& other, const_iterator first,
+                                const_iterator last) {
+    assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    if (this != &other) {
+        size_type count = static_cast<size_type>(std::distance(first, last));
+        size_ += count;
+        other.size_ -= count;
+    }
+    Transfer(MutableNode(pos), MutableNode(first), MutableNode(last));
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Splice(const_iterator pos, List&& other, const_iterator first,
+                                const_iterator last) {
+    Splice(pos, other, first, last);
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Merge(List& other) {
+    Merge(other, std::less<>());
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Merge(List&& other) {
+    Merge(other, std::less<>());
+}
+
+// Relinks other's nodes into place without allocating. Stable: on ties this list's elements come
+// first. If `comp` throws, both lists stay valid and keep every element.
+template <typename T, typename Allocator>
+template <typename Compare>
+void List<T, Allocator>::Merge(List& other, Compare comp) {
+    assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    if (this == &other) {
+        return;
+    }
+    NodeBase* node = head_.next;
+    while (node != &head_ && !other.Empty()) {
+        NodeBase* first = other.head_.next;
+        if (!comp(static_cast<Node*>(first)->value, static_cast<Node*>(node)->value)) {
+            node = node->next;
+            continue;
+        }
+        // Move the whole stretch of other's nodes that sorts before `node` at once.
+        NodeBase* last = first->next;
+        size_type count = 1;
+        while (last != &other.head_ &&
+               comp(static_cast<Node*>(last)->value, static_cast<Node*>(node)->value)) {
+            last = last->next;
+            ++count;
+        }
+        Transfer(node, first, last);
+        size_ += count;
+        other.size_ -= count;
+    }
+    Splice(End(), other);
+}
+
+template <typename T, typename Allocator>
+template <typename Compare>
+void List<T, Allocator>::Merge(List&& other, Compare comp) {
+    Merge(other, std::move(comp));
+}
+
+// Merge sort that only relinks nodes: stable, allocation-free and O(n) on sorted input. If a
+// comparison throws, every element is still in the list, in unspecified order.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Sort() {
+    if (size_ < 2) {
+        return;
+    }
+    NodeLess less;
+    head_.prev->next = nullptr;
+    NodeBase* chain = head_.next;
+    try {
+        Sorter::Sort(chain, less);
+    } catch (...) {
+        RelinkSorted(chain);
+        throw;
+    }
+    RelinkSorted(chain);
+}
+
+// Cuts the list into one piece per thread, sorts the pieces concurrently and then merges them
+// pairwise, running each round's merges concurrently too. Nodes are only relinked, and pieces keep
+// their left-to-right order through every round, so the result equals Sort()'s. If a comparison
+// throws or a thread cannot be started, the tasks already running are joined and every element is
+// put back in the list, in unspecified order.
+template <typename T, typename Allocator>
+void List<T, Allocator>::ParallelSort(std::size_t max_threads) {
+    std::size_t pieces = std::min<std::size_t>(max_threads, size_ / (kParallelSortThreshold / 2));
+    if (size_ < kParallelSortThreshold || pieces < 2) {
+        Sort();
+        return;
+    }
+
+    std::vector<NodeBase*> heads;
+    heads.reserve(pieces);
+    head_.prev->next = nullptr;
+    NodeBase* node = head_.next;
+    for (std::size_t i = 0; i < pieces; ++i) {
+        heads.push_back(node);
+        size_type count = size_ / pieces + (i < size_ % pieces ? 1 : 0);
+        for (size_type j = 1; j < count; ++j) {
+            node = node->next;
+        }
+        NodeBase* next = node->next;
+        node->next = nullptr;
+        node = next;
+    }
+
+    // Runs task(0) .. task(count - 1), all but the first on their own threads.
+    auto run_concurrently = [](std::size_t count, const auto& task) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(count);
+        for (std::size_t i = 1; i < count; ++i) {
+            futures.push_back(std::async(std::launch::async, task, i));
+        }
+        task(0);
+        for (std::future<void>& future : futures) {
+            future.get();
+        }
+    };
+
+    // Every node stays on exactly one of the chains in `heads`, also when a task throws.
+    try {
+        run_concurrently(heads.size(), [&heads](std::size_t i) {
+            NodeLess less;
+            Sorter::Sort(heads[i], less);
+        });
+        while (heads.size() > 1) {
+            run_concurrently(heads.size() / 2, [&heads](std::size_t i) {
+                NodeLess less;
+                NodeBase* rhs = heads[2 * i + 1];
+                heads[2 * i + 1] = nullptr;
+                Sorter::Merge(heads[2 * i], rhs, less);
+            });
+            for (std::size_t i = 0; i < heads.size(); i += 2) {
+                heads[i / 2] = heads[i];
+            }
+            heads.resize((heads.size() + 1) / 2);
+        }
+    } catch (...) {
+        NodeBase* chain = nullptr;
+        for (auto it = heads.rbegin(); it != heads.rend(); ++it) {
+            chain = Sorter::Concat(*it, chain);
+        }
+        RelinkSorted(chain);
+        throw;
+    }
+    RelinkSorted(heads.front());
+}
+
+// All fresh nodes are allocated while the old ones are still live, so none of them reuses an old
+// slot; they are then sorted by address and handed out in traversal order. This briefly doubles
+// the list's footprint. If allocation fails the list is untouched; if moving an element throws,
+// the elements moved so far stay in their fresh nodes and the rest stay where they were.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Compact() {
+    using PointerAllocator = typename NodeTraits::template rebind_alloc<Node*>;
+    std::vector<Node*, PointerAllocator> fresh{PointerAllocator(alloc_)};
+    fresh.reserve(size_);
+    try {
+        for (size_type i = 0; i < size_; ++i) {
+            fresh.push_back(NodeTraits::allocate(alloc_, 1));
+        }
+    } catch (...) {
+        for (Node* node : fresh) {
+            NodeTraits::deallocate(alloc_, node, 1);
+        }
+        throw;
+    }
+    std::sort(fresh.begin(), fresh.end(), std::less<Node*>());
+
+    auto next_fresh = fresh.begin();
+    try {
+        NodeBase* node = head_.next;
+        while (node != &head_) {
+            Node* old_node = static_cast<Node*>(node);
+            Node* new_node = *next_fresh;
+            NodeTraits::construct(alloc_, std::addressof(new_node->value),
+                                  std::move_if_noexcept(old_node->value));
+            ++next_fresh;
+            node = node->next;
+
+            new_node->prev = old_node->prev;
+            new_node->next = old_node->next;
+            new_node->prev->next = new_node;
+            new_node->next->prev = new_node;
+            DestroyNode(old_node);
+        }
+    } catch (...) {
+        for (; next_fresh != fresh.end(); ++next_fresh) {
+            NodeTraits::deallocate(alloc_, *next_fresh, 1);
+        }
+        throw;
+    }
+}
+
+template <typename T, typename Allocator>
+typename List<T, Allocator>::allocator_type List<T, Allocator>::GetAllocator() const noexcept {
+    return allocator_type(alloc_);
+}
+
+// Private
+template <typename T, typename Allocator>
+template <typename... Args>
+typename List<T, Allocator>::Node* List<T, Allocator>::CreateNode(Args&&... args) {
+    Node* node = NodeTraits::allocate(alloc_, 1);
+    try {
+        NodeTraits::construct(alloc_, std::addressof(node->value), std::forward<Args>(args)...);
+    } catch (...) {
+        NodeTraits::deallocate(alloc_, node, 1);
+        throw;
+    }
+    return node;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::DestroyNode(NodeBase* node) noexcept {
+    Node* full = static_cast<Node*>(node);
+    NodeTraits::destroy(alloc_, std::addressof(full->value));
+    NodeTraits::deallocate(alloc_, full, 1);
+}
+
+// Destroys a null-terminated chain of unlinked nodes.
+template <typename T, typename Allocator>
+void List<T, Allocator>::DestroyChain(NodeBase* first) noexcept {
+    while (first != nullptr) {
+        NodeBase* next = first->next;
+        DestroyNode(first);
+        first = next;
+    }
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+typename List<T, Allocator>::NodeBase* List<T, Allocator>::EmplaceBefore(NodeBase* pos,
+                                                                         Args&&... args) {
+    NodeBase* node = CreateNode(std::forward<Args>(args)...);
+    LinkBefore(pos, node);
+    ++size_;
+    return node;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Erase(NodeBase* node) noexcept {
+    Unlink(node);
+    DestroyNode(node);
+    --size_;
+}
+
+// A const_iterator only holds a pointer to const, but its neighbour's link to it does not.
+template <typename T, typename Allocator>
+typename List<T, Allocator>::NodeBase* List<T, Allocator>::MutableNode(
+    const_iterator pos) noexcept {
+    return pos.node_->prev->next;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::LinkBefore(NodeBase* pos, NodeBase* node) noexcept {
+    node->next = pos;
+    node->prev = pos->prev;
+    pos->prev->next = node;
+    pos->prev = node;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::Unlink(NodeBase* node) noexcept {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+}
+
+// Relinks [first, last) before `pos`; the range must not contain `pos`.
+template <typename T, typename Allocator>
+void List<T, Allocator>::Transfer(NodeBase* pos, NodeBase* first, NodeBase* last) noexcept {
+    if (first == last) {
+        return;
+    }
+    NodeBase* last_node = last->prev;
+    first->prev->next = last;
+    last->prev = first->prev;
+
+    last_node->next = pos;
+    first->prev = pos->prev;
+    pos->prev->next = first;
+    pos->prev = last_node;
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::ResetHead() noexcept {
+    head_.prev = &head_;
+    head_.next = &head_;
+    size_ = 0;
+}
+
+// Adopts other's nodes; requires this list to be empty and the allocators to be compatible.
+template <typename T, typename Allocator>
+void List<T, Allocator>::StealNodes(List& other) noexcept {
+    if (other.Empty()) {
+        return;
+    }
+    head_ = other.head_;
+    size_ = other.size_;
+    head_.next->prev = &head_;
+    head_.prev->next = &head_;
+    other.ResetHead();
+}
+
+template <typename T, typename Allocator>
+void List<T, Allocator>::MoveElements(List& other) {
+    for (NodeBase* node = other.head_.next; node != &other.head_; node = node->next) {
+        EmplaceBack(std::move(static_cast<Node*>(node)->value));
+    }
+    other.Clear();
+}
+
+// Reuses existing nodes by assigning into them before allocating or freeing any.
+template <typename T, typename Allocator>
+template <typename Iter>
+void List<T, Allocator>::AssignRange(Iter first, Iter last) {
+    NodeBase* node = head_.next;
+    for (; node != &head_ && first != last; node = node->next, ++first) {
+        static_cast<Node*>(node)->value = *first;
+    }
+    for (; first != last; ++first) {
+        EmplaceBack(*first);
+    }
+    while (node != &head_) {
+        NodeBase* next = node->next;
+        Erase(node);
+        node = next;
+    }
+}
+
+// Re-attaches a null-terminated chain, normally the sorted one, to the sentinel and restores the
+// `prev` links.
+template <typename T, typename Allocator>
+void List<T, Allocator>::RelinkSorted(NodeBase* first) noexcept {
+    NodeBase* prev = &head_;
+    for (NodeBase* node = first; node != nullptr; node = node->next) {
+        node->prev = prev;
+        prev->next = node;
+        prev = node;
+    }
+    prev->next = &head_;
+    head_.prev = prev;
+}
+
+}  // namespace task
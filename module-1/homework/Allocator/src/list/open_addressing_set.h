@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace task {
+
+// Linear-probing hash set of pointers to values that live elsewhere (e.g. in list nodes): probes
+// hash and compare the pointed-to values, and each slot caches its hash so that a probe only calls
+// KeyEqual on a full hash match. The table is a power of two kept at most half full.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+class OpenAddressingSet {
+    struct Slot {
+        std::size_t hash;
+        const T* value;
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using SlotTraits = std::allocator_traits<SlotAllocator>;
+
+public:
+    OpenAddressingSet(std::size_t expected_size, const Hash& hash, const KeyEqual& equal,
+                      const Allocator& alloc)
+        : hash_(hash), equal_(equal), alloc_(alloc) {
+        std::size_t capacity = kMinCapacity;
+        while (capacity / 2 < expected_size) {
+            capacity *= 2;
+        }
+        Allocate(capacity);
+    }
+
+    OpenAddressingSet(const OpenAddressingSet&) = delete;
+    OpenAddressingSet& operator=(const OpenAddressingSet&) = delete;
+
+    ~OpenAddressingSet() {
+        SlotTraits::deallocate(alloc_, slots_, capacity_);
+    }
+
+    // Adds `value` unless an equal value is already present; returns whether it was added.
+    // The pointee must stay alive and unchanged while the set is in use.
+    bool Insert(const T* value) {
+        if (size_ + 1 > capacity_ / 2) {
+            Grow();
+        }
+        std::size_t hash = hash_(*value);
+        for (std::size_t i = Index(hash);; i = (i + 1) & (capacity_ - 1)) {
+            Slot& slot = slots_[i];
+            if (slot.value == nullptr) {
+                slot = {hash, value};
+                ++size_;
+                return true;
+            }
+            if (slot.hash == hash && equal_(*slot.value, *value)) {
+                return false;
+            }
+        }
+    }
+
+    std::size_t Size() const noexcept {
+        return size_;
+    }
+
+private:
+    static constexpr std::size_t kMinCapacity = 16;
+
+    // Fibonacci hashing spreads weak hashes, such as std::hash<int>'s identity, over the table.
+    std::size_t Index(std::size_t hash) const noexcept {
+        constexpr std::uint64_t kGoldenRatio = 0x9E3779B97F4A7C15ull;
+        std::uint64_t mixed = static_cast<std::uint64_t>(hash) * kGoldenRatio;
+        return static_cast<std::size_t>(mixed >> shift_);
+    }
+
+    void Allocate(std::size_t capacity) {
+        slots_ = SlotTraits::allocate(alloc_, capacity);
+        std::uninitialized_fill_n(slots_, capacity, Slot{0, nullptr});
+        capacity_ = capacity;
+        shift_ = 64;
+        for (std::size_t c = capacity; c > 1; c /= 2) {
+            --shift_;
+        }
+    }
+
+    void Grow() {
+        Slot* old_slots = slots_;
+        std::size_t old_capacity = capacity_;
+        Allocate(2 * capacity_);
+        for (std::size_t i = 0; i < old_capacity; ++i) {
+            if (old_slots[i].value != nullptr) {
+                std::size_t j = Index(old_slots[i].hash);
+                while (slots_[j].value != nullptr) {
+                    j = (j + 1) & (capacity_ - 1);
+                }
+                slots_[j] = old_slots[i];
+            }
+        }
+        SlotTraits::deallocate(alloc_, old_slots, old_capacity);
+    }
+
+    Hash hash_;
+    KeyEqual equal_;
+    SlotAllocator alloc_;
+    Slot* slots_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    unsigned shift_ = 64;
+};
+
+}  // namespace task
@@ -0,0 +1,577 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace task {
+
+// Unrolled counterpart of task::List: every node stores up to kNodeCapacity elements in an inline
+// array, so traversal takes one pointer hop (and usually one cache miss) per node rather than per
+// element. Node capacity is chosen so that a node fills one cache line, or two for large T.
+template <typename T, typename Allocator = std::allocator<T>>
+class UnrolledList {
+    struct NodeBase {
+        NodeBase* prev;
+        NodeBase* next;
+        // Elements live in [first, last) of the node's slots.
+        uint16_t first;
+        uint16_t last;
+    };
+
+    static constexpr std::size_t kCacheLine = 64;
+
+    static constexpr std::size_t CapacityFor(std::size_t node_bytes) {
+        return node_bytes > sizeof(NodeBase) ? (node_bytes - sizeof(NodeBase)) / sizeof(T) : 0;
+    }
+
+public:
+    static constexpr std::size_t kNodeCapacity =
+        CapacityFor(kCacheLine) >= 4
+            ? CapacityFor(kCacheLine)
+            : (CapacityFor(2 * kCacheLine) >= 1 ? CapacityFor(2 * kCacheLine) : 1);
+
+private:
+    struct Node : NodeBase {
+        alignas(T) unsigned char storage[kNodeCapacity * sizeof(T)];
+
+        T* Slot(std::size_t index) noexcept {
+            return std::launder(reinterpret_cast<T*>(storage) + index);
+        }
+        const T* Slot(std::size_t index) const noexcept {
+            return std::launder(reinterpret_cast<const T*>(storage) + index);
+        }
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        Iterator(const Iterator<WasConst>& other) noexcept  // NOLINT
+            : node_(other.node_), index_(other.index_) {
+        }
+
+        reference operator*() const noexcept {
+            return *static_cast<NodePtr>(node_)->Slot(index_);
+        }
+        pointer operator->() const noexcept {
+            return static_cast<NodePtr>(node_)->Slot(index_);
+        }
+
+        Iterator& operator++() noexcept {
+            if (++index_ == node_->last) {
+                node_ = node_->next;
+                index_ = node_->first;
+            }
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+        Iterator& operator--() noexcept {
+            if (index_ == node_->first) {
+                node_ = node_->prev;
+                index_ = node_->last;
+            }
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int) noexcept {
+            Iterator copy(*this);
+            --*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.node_ == rhs.node_ && lhs.index_ == rhs.index_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+    private:
+        friend class UnrolledList;
+
+        using BasePtr = std::conditional_t<IsConst, const NodeBase*, NodeBase*>;
+        using NodePtr = std::conditional_t<IsConst, const Node*, Node*>;
+
+        Iterator(BasePtr node, std::size_t index) noexcept : node_(node), index_(index) {
+        }
+
+        BasePtr node_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // Special member functions
+    UnrolledList() : UnrolledList(Allocator()) {
+    }
+    explicit UnrolledList(const Allocator& alloc) : alloc_(alloc) {
+        ResetHead();
+    }
+
+    UnrolledList(const UnrolledList& other)
+        : UnrolledList(Allocator(NodeTraits::select_on_container_copy_construction(other.alloc_))) {
+        for (auto it = other.Begin(); it != other.End(); ++it) {
+            PushBack(*it);
+        }
+    }
+
+    UnrolledList(UnrolledList&& other) noexcept : alloc_(std::move(other.alloc_)) {
+        ResetHead();
+        StealNodes(other);
+    }
+
+    ~UnrolledList() {
+        Clear();
+    }
+
+    UnrolledList& operator=(const UnrolledList& other);
+    UnrolledList& operator=(UnrolledList&& other) noexcept(
+        NodeTraits::propagate_on_container_move_assignment::value ||
+        NodeTraits::is_always_equal::value);
+
+    // Element access
+    reference Front() {
+        return *AsNode(head_.next)->Slot(head_.next->first);
+    }
+    const_reference Front() const {
+        return *AsNode(head_.next)->Slot(head_.next->first);
+    }
+    reference Back() {
+        return *AsNode(head_.prev)->Slot(head_.prev->last - 1);
+    }
+    const_reference Back() const {
+        return *AsNode(head_.prev)->Slot(head_.prev->last - 1);
+    }
+
+    // Iterators
+    iterator Begin() noexcept {
+        return iterator(head_.next, head_.next->first);
+    }
+    const_iterator Begin() const noexcept {
+        return const_iterator(head_.next, head_.next->first);
+    }
+    iterator End() noexcept {
+        return iterator(&head_, 0);
+    }
+    const_iterator End() const noexcept {
+        return const_iterator(&head_, 0);
+    }
+
+    // Capacity
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+    size_type Size() const noexcept {
+        return size_;
+    }
+
+    // Modifiers
+    void Clear();
+    void Swap(UnrolledList& other) noexcept;
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+    template <typename... Args>
+    void EmplaceBack(Args&&... args);
+    void PopBack();
+
+    void PushFront(const T& value) {
+        EmplaceFront(value);
+    }
+    void PushFront(T&& value) {
+        EmplaceFront(std::move(value));
+    }
+    template <typename... Args>
+    void EmplaceFront(Args&&... args);
+    void PopFront();
+
+    void Resize(size_type count);
+    void Resize(size_type count, const value_type& value);
+
+    // Operations
+    void Remove(const T& value);
+    void Unique();
+    void Sort();
+
+    allocator_type GetAllocator() const noexcept {
+        return allocator_type(alloc_);
+    }
+
+private:
+    static Node* AsNode(NodeBase* node) noexcept {
+        return static_cast<Node*>(node);
+    }
+    static const Node* AsNode(const NodeBase* node) noexcept {
+        return static_cast<const Node*>(node);
+    }
+
+    NodeBase* LinkNewNode(NodeBase* pos, uint16_t index);
+    void UnlinkNode(NodeBase* node) noexcept;
+    void DestroyNode(NodeBase* node) noexcept;
+
+    template <typename Keep>
+    void Compact(Keep keep);
+
+    void ResetHead() noexcept {
+        head_ = {&head_, &head_, 0, 0};
+        size_ = 0;
+    }
+    void StealNodes(UnrolledList& other) noexcept;
+
+    NodeBase head_;
+    size_type size_ = 0;
+    NodeAllocator alloc_;
+};
+
+template <typename T, typename Allocator>
+UnrolledList<T, Allocator>& UnrolledList<T, Allocator>::operator=(const UnrolledList& other) {
+    if (this == &other) {
+        return *this;
+    }
+    Clear();
+    if constexpr (NodeTraits::propagate_on_container_copy_assignment::value) {
+        alloc_ = other.alloc_;
+    }
+    for (auto it = other.Begin(); it != other.End(); ++it) {
+        PushBack(*it);
+    }
+    return *this;
+}
+
+template <typename T, typename Allocator>
+UnrolledList<T, Allocator>& UnrolledList<T, Allocator>::operator=(UnrolledList&& other) noexcept(
+    NodeTraits::propagate_on_container_move_assignment::value ||
+    NodeTraits::is_always_equal::value) {
+    if (this == &other) {
+        return *this;
+    }
+    Clear();
+    if constexpr (NodeTraits::propagate_on_container_move_assignment::value) {
+        alloc_ = std::move(other.alloc_);
+        StealNodes(other);
+    } else {
+        if (NodeTraits::is_always_equal::value || alloc_ == other.alloc_) {
+            StealNodes(other);
+        } else {
+            for (auto it = other.Begin(); it != other.End(); ++it) {
+                PushBack(std::move(*it));
+            }
+            other.Clear();
+        }
+    }
+    return *this;
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Clear() {
+    NodeBase* node = head_.next;
+    while (node != &head_) {
+        NodeBase* next = node->next;
+        DestroyNode(node);
+        node = next;
+    }
+    ResetHead();
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Swap(UnrolledList& other) noexcept {
+    if constexpr (NodeTraits::propagate_on_container_swap::value) {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+    } else {
+        assert(NodeTraits::is_always_equal::value || alloc_ == other.alloc_);
+    }
+
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    for (UnrolledList* list : {this, &other}) {
+        if (list->size_ == 0) {
+            list->ResetHead();
+        } else {
+            list->head_.next->prev = &list->head_;
+            list->head_.prev->next = &list->head_;
+        }
+    }
+}
+
+// A full tail gets a fresh node that fills from slot 0 upwards.
+template <typename T, typename Allocator>
+template <typename... Args>
+void UnrolledList<T, Allocator>::EmplaceBack(Args&&... args) {
+    NodeBase* tail = head_.prev;
+    if (tail == &head_ || tail->last == kNodeCapacity) {
+        tail = LinkNewNode(&head_, 0);
+    }
+    try {
+        NodeTraits::construct(alloc_, AsNode(tail)->Slot(tail->last), std::forward<Args>(args)...);
+    } catch (...) {
+        if (tail->first == tail->last) {
+            UnlinkNode(tail);
+        }
+        throw;
+    }
+    ++tail->last;
+    ++size_;
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::PopBack() {
+    NodeBase* tail = head_.prev;
+    NodeTraits::destroy(alloc_, AsNode(tail)->Slot(--tail->last));
+    if (tail->first == tail->last) {
+        UnlinkNode(tail);
+    }
+    --size_;
+}
+
+// A full head gets a fresh node that fills from its last slot downwards, so repeated
+// EmplaceFront never shifts elements.
+template <typename T, typename Allocator>
+template <typename... Args>
+void UnrolledList<T, Allocator>::EmplaceFront(Args&&... args) {
+    NodeBase* front = head_.next;
+    if (front == &head_ || front->first == 0) {
+        front = LinkNewNode(head_.next, kNodeCapacity);
+    }
+    try {
+        NodeTraits::construct(alloc_, AsNode(front)->Slot(front->first - 1),
+                              std::forward<Args>(args)...);
+    } catch (...) {
+        if (front->first == front->last) {
+            UnlinkNode(front);
+        }
+        throw;
+    }
+    --front->first;
+    ++size_;
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::PopFront() {
+    NodeBase* front = head_.next;
+    NodeTraits::destroy(alloc_, AsNode(front)->Slot(front->first++));
+    if (front->first == front->last) {
+        UnlinkNode(front);
+    }
+    --size_;
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Resize(size_type count) {
+    while (size_ > count) {
+        PopBack();
+    }
+    while (size_ < count) {
+        EmplaceBack();
+    }
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Resize(size_type count, const value_type& value) {
+    while (size_ > count) {
+        PopBack();
+    }
+    while (size_ < count) {
+        PushBack(value);
+    }
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Remove(const T& value) {
+    // `value` may be one of our elements; it is moved aside before its slot is destroyed.
+    const T* target = std::addressof(value);
+    std::optional<T> saved;
+    Compact([&](T& current, const T*) {
+        if (!(current == *target)) {
+            return true;
+        }
+        if (std::addressof(current) == target) {
+            saved.emplace(std::move(current));
+            target = std::addressof(*saved);
+        }
+        return false;
+    });
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Unique() {
+    Compact([](T& current, const T* kept) { return kept == nullptr || !(current == *kept); });
+}
+
+// Elements are sorted in a flat buffer and moved back into the same slots; no node is touched.
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::Sort() {
+    std::vector<T> values(std::make_move_iterator(Begin()), std::make_move_iterator(End()));
+    std::stable_sort(values.begin(), values.end());
+    std::move(values.begin(), values.end(), Begin());
+}
+
+// Links an empty node before `pos` whose [first, last) starts out as [index, index).
+template <typename T, typename Allocator>
+typename UnrolledList<T, Allocator>::NodeBase* UnrolledList<T, Allocator>::LinkNewNode(
+    NodeBase* pos, uint16_t index) {
+    Node* node = NodeTraits::allocate(alloc_, 1);
+    node->first = index;
+    node->last = index;
+    node->next = pos;
+    node->prev = pos->prev;
+    pos->prev->next = node;
+    pos->prev = node;
+    return node;
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::UnlinkNode(NodeBase* node) noexcept {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    NodeTraits::deallocate(alloc_, AsNode(node), 1);
+}
+
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::DestroyNode(NodeBase* node) noexcept {
+    for (uint16_t i = node->first; i < node->last; ++i) {
+        NodeTraits::destroy(alloc_, AsNode(node)->Slot(i));
+    }
+    NodeTraits::deallocate(alloc_, AsNode(node), 1);
+}
+
+// Streams every element through `keep(element, last_kept_or_null)` and packs the survivors into
+// full nodes from the front, freeing the nodes left empty. The writer never overtakes the reader,
+// so its slot is always either the reader's own or one whose element is already destroyed.
+// Relocation relies on T's nothrow move; if `keep` throws, the elements not yet visited are
+// packed up against the kept ones with those same moves, so the list stays whole.
+template <typename T, typename Allocator>
+template <typename Keep>
+void UnrolledList<T, Allocator>::Compact(Keep keep) {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "Compact must not be left with a gap in a node by a throwing move");
+    if (size_ == 0) {
+        return;
+    }
+    NodeBase* writer = head_.next;
+    uint16_t write_index = writer->first;
+    const T* kept = nullptr;
+    size_type kept_count = 0;
+    size_type removed = 0;
+
+    NodeBase* reader = head_.next;
+    uint16_t index = reader->first;
+    try {
+        for (; reader != &head_; reader = reader->next) {
+            for (index = reader->first; index < reader->last; ++index) {
+                T* current = AsNode(reader)->Slot(index);
+                if (!keep(*current, kept)) {
+                    NodeTraits::destroy(alloc_, current);
+                    ++removed;
+                    continue;
+                }
+                if (write_index == kNodeCapacity) {
+                    writer->last = write_index;
+                    writer = writer->next;
+                    writer->first = 0;
+                    write_index = 0;
+                }
+                T* slot = AsNode(writer)->Slot(write_index);
+                if (slot != current) {
+                    NodeTraits::construct(alloc_, slot, std::move(*current));
+                    NodeTraits::destroy(alloc_, current);
+                }
+                kept = slot;
+                ++write_index;
+                ++kept_count;
+            }
+        }
+    } catch (...) {
+        // [writer->first, write_index) is packed and [index, reader->last) is untouched; every
+        // slot between them has been destroyed or moved from.
+        if (writer == reader) {
+            for (; index < reader->last; ++index, ++write_index) {
+                T* current = AsNode(reader)->Slot(index);
+                T* slot = AsNode(writer)->Slot(write_index);
+                if (slot != current) {
+                    NodeTraits::construct(alloc_, slot, std::move(*current));
+                    NodeTraits::destroy(alloc_, current);
+                }
+            }
+            writer->last = write_index;
+        } else {
+            writer->last = write_index;
+            while (writer->next != reader) {
+                UnlinkNode(writer->next);
+            }
+            reader->first = index;
+            if (writer->first == writer->last) {
+                UnlinkNode(writer);
+            }
+        }
+        size_ -= removed;
+        throw;
+    }
+
+    // Every element is now either packed before the writer or destroyed.
+    if (kept_count == 0) {
+        for (NodeBase* node = head_.next; node != &head_;) {
+            NodeBase* next = node->next;
+            NodeTraits::deallocate(alloc_, AsNode(node), 1);
+            node = next;
+        }
+        ResetHead();
+        return;
+    }
+    writer->last = write_index;
+    while (writer->next != &head_) {
+        UnlinkNode(writer->next);
+    }
+    size_ = kept_count;
+}
+
+// Adopts other's nodes; requires this list to be empty and the allocators to be compatible.
+template <typename T, typename Allocator>
+void UnrolledList<T, Allocator>::StealNodes(UnrolledList& other) noexcept {
+    if (other.Empty()) {
+        return;
+    }
+    head_ = other.head_;
+    size_ = other.size_;
+    head_.next->prev = &head_;
+    head_.prev->next = &head_;
+    other.ResetHead();
+}
+
+}  // namespace task
@@ -1,11 +1,21 @@
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "src/allocator/allocator.h"
+#include "src/allocator/memory_resource.h"
+#include "src/list/concurrent_queue.h"
+#include "src/list/intrusive_list.h"
 #include "src/list/list.h"
+#include "src/list/prefetch.h"
+#include "src/list/unrolled_list.h"
 
 TEST(CopyAssignment, Test) {
     task::List<std::string, CustomAllocator<std::string>> actual;
@@ -38,6 +48,59 @@ TEST(MoveAssignment, Test1) {
     ASSERT_TRUE(std::equal(l2.Begin(), l2.End(), l4.begin(), l4.end()));
 }
 
+TEST(MoveAssignment, Test2) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc(stats);
+    task::List<std::string, CustomAllocator<std::string>> l1(alloc);
+    task::List<std::string, CustomAllocator<std::string>> l2;
+    for (std::size_t i = 0; i < 10; i++) {
+        l1.PushBack("hello");
+    }
+
+    uint64_t allocations = stats->Collect().allocations;
+    l2 = std::move(l1);
+    ASSERT_EQ(stats->Collect().allocations, allocations);
+    ASSERT_TRUE(l2.GetAllocator() == alloc);
+    ASSERT_EQ(l2.Size(), 10);
+    ASSERT_TRUE(l1.Empty());
+}
+
+TEST(MoveAssignment, Test3) {
+    auto stats = std::make_shared<AllocatorStats>();
+    PoolResource pool1;
+    PoolResource pool2;
+    InstrumentedResource instrumented(&pool2, stats);
+    task::List<std::string, PolymorphicAllocator<std::string>> l1(
+        PolymorphicAllocator<std::string>{&pool1});
+    task::List<std::string, PolymorphicAllocator<std::string>> l2(
+        PolymorphicAllocator<std::string>{&instrumented});
+    std::list<std::string> expected;
+    for (std::size_t i = 0; i < 10; i++) {
+        l1.PushBack("hello");
+        expected.push_back("hello");
+    }
+
+    // The allocators differ and do not propagate, so every element gets a node from l2's.
+    l2 = std::move(l1);
+    ASSERT_EQ(stats->Collect().allocations, 10);
+    ASSERT_TRUE(l2.GetAllocator().Resource() == &instrumented);
+    ASSERT_TRUE(std::equal(l2.Begin(), l2.End(), expected.begin(), expected.end()));
+}
+
+TEST(MoveConstructor, Test1) {
+    PoolResource pool1;
+    PoolResource pool2;
+    task::List<int, PolymorphicAllocator<int>> l1(PolymorphicAllocator<int>{&pool1});
+    for (int i = 0; i < 10; i++) {
+        l1.PushBack(i);
+    }
+    task::List<int, PolymorphicAllocator<int>> l2(std::move(l1), PolymorphicAllocator<int>{&pool1});
+    task::List<int, PolymorphicAllocator<int>> l3(std::move(l2), PolymorphicAllocator<int>{&pool2});
+    ASSERT_TRUE(l1.Empty() && l2.Empty());
+    ASSERT_EQ(l3.Size(), 10);
+    ASSERT_EQ(l3.Back(), 9);
+}
+
 TEST(Front, Test1) {
     task::List<std::string, CustomAllocator<std::string>> actual;
     std::list<std::string, CustomAllocator<std::string>> expected;
@@ -93,6 +156,24 @@ TEST(Swap, Test1) {
     ASSERT_TRUE(std::equal(actual2.Begin(), actual2.End(), expected2.begin(), expected2.end()));
 }
 
+TEST(Swap, Test2) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc1(stats);
+    CustomAllocator<std::string> alloc2(stats);
+    task::List<std::string, CustomAllocator<std::string>> actual(alloc1);
+    task::List<std::string, CustomAllocator<std::string>> actual2(alloc2);
+    for (std::size_t i = 0; i < 10; i++) {
+        actual.PushBack("hello");
+    }
+
+    uint64_t allocations = stats->Collect().allocations;
+    actual.Swap(actual2);
+    ASSERT_EQ(stats->Collect().allocations, allocations);
+    ASSERT_TRUE(actual.Empty());
+    ASSERT_EQ(actual2.Size(), 10);
+    ASSERT_TRUE(actual.GetAllocator() == alloc2 && actual2.GetAllocator() == alloc1);
+}
+
 TEST(PushBack, Test) {
     std::vector<std::string> actual_v(10, "hello");
     std::vector<std::string> expected_v(10, "hello");
@@ -233,6 +314,353 @@ TEST(Sort, Test1) {
     ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
 }
 
+TEST(Sort, Test2) {
+    // Ordered by key only, so a stable sort must keep equal keys in insertion order.
+    struct Item {
+        int key;
+        int order;
+        bool operator<(const Item& other) const {
+            return key < other.key;
+        }
+        bool operator==(const Item& other) const {
+            return key == other.key && order == other.order;
+        }
+    };
+    std::mt19937 random_engine(42);
+    std::vector<Item> expected;
+    for (int i = 0; i < 10000; ++i) {
+        expected.push_back({static_cast<int>(random_engine() % 50), i});
+    }
+    // Already sorted and reversed stretches exercise the natural run detection.
+    std::sort(expected.begin() + 2000, expected.begin() + 5000,
+              [](const Item& lhs, const Item& rhs) { return lhs.order < rhs.order; });
+    std::reverse(expected.begin() + 5000, expected.end());
+
+    task::List<Item, CustomAllocator<Item>> actual;
+    for (const Item& item : expected) {
+        actual.PushBack(item);
+    }
+    actual.Sort();
+    std::stable_sort(expected.begin(), expected.end());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+
+    actual.Sort();
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+TEST(Sort, Test3) {
+    struct Item {
+        int key;
+        int order;
+        bool operator<(const Item& other) const {
+            return key < other.key;
+        }
+        bool operator==(const Item& other) const {
+            return key == other.key && order == other.order;
+        }
+    };
+    using List = task::List<Item, CustomAllocator<Item>>;
+    std::mt19937 random_engine(7);
+    std::vector<Item> expected;
+    for (std::size_t i = 0; i < 5 * List::kParallelSortThreshold + 3; ++i) {
+        expected.push_back({static_cast<int>(random_engine() % 1000), static_cast<int>(i)});
+    }
+
+    List actual;
+    for (const Item& item : expected) {
+        actual.PushBack(item);
+    }
+    actual.ParallelSort(4);
+    std::stable_sort(expected.begin(), expected.end());
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+}
+
+namespace {
+
+// Throws from operator< once `budget` comparisons have been made, from whichever thread.
+struct FragileKey {
+    static std::atomic<long> budget;
+
+    int key;
+    bool operator<(const FragileKey& other) const {
+        if (budget.fetch_sub(1) <= 0) {
+            throw std::runtime_error("comparison failed");
+        }
+        return key < other.key;
+    }
+};
+
+std::atomic<long> FragileKey::budget{0};
+
+}  // namespace
+
+// A throwing comparison leaves every element linked in both directions, in some order.
+TEST(Sort, Test4) {
+    using List = task::List<FragileKey, CustomAllocator<FragileKey>>;
+    const std::size_t size = 3 * List::kParallelSortThreshold;
+    for (long budget : {0L, 1L, 1000L, 100000L, 300000L}) {
+        for (bool parallel : {false, true}) {
+            std::mt19937 random_engine(budget);
+            List list;
+            std::vector<int> expected;
+            for (std::size_t i = 0; i < size; ++i) {
+                expected.push_back(static_cast<int>(random_engine() % 1000));
+                list.PushBack({expected.back()});
+            }
+            FragileKey::budget = budget;
+            if (parallel) {
+                ASSERT_THROW(list.ParallelSort(4), std::runtime_error);
+            } else {
+                ASSERT_THROW(list.Sort(), std::runtime_error);
+            }
+
+            std::vector<int> forward;
+            for (auto it = list.Begin(); it != list.End(); ++it) {
+                forward.push_back(it->key);
+            }
+            std::vector<int> backward;
+            for (auto it = list.End(); it != list.Begin();) {
+                backward.push_back((--it)->key);
+            }
+            ASSERT_EQ(list.Size(), size);
+            ASSERT_TRUE(std::equal(forward.begin(), forward.end(), backward.rbegin(),
+                                   backward.rend()));
+            std::sort(forward.begin(), forward.end());
+            std::sort(expected.begin(), expected.end());
+            ASSERT_EQ(forward, expected);
+        }
+    }
+}
+
+TEST(Insert, Test1) {
+    task::List<std::string, CustomAllocator<std::string>> actual;
+    std::list<std::string> expected;
+    actual.Insert(actual.End(), "world");
+    expected.insert(expected.end(), "world");
+    auto it = actual.Insert(actual.Begin(), 2, "hello");
+    ASSERT_EQ(it, actual.Begin());
+    expected.insert(expected.begin(), 2, "hello");
+
+    std::vector<std::string> values{"a", "b", "c"};
+    it = actual.Insert(std::next(actual.Begin()), values.begin(), values.end());
+    ASSERT_EQ(*it, "a");
+    expected.insert(std::next(expected.begin()), values.begin(), values.end());
+    it = actual.Emplace(actual.End(), 3, '!');
+    ASSERT_EQ(*it, "!!!");
+    expected.emplace(expected.end(), 3, '!');
+
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+TEST(Erase, Test1) {
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    for (int i = 0; i < 10; ++i) {
+        actual.PushBack(i);
+        expected.push_back(i);
+    }
+    auto it = actual.Erase(actual.Begin());
+    ASSERT_EQ(*it, 1);
+    expected.erase(expected.begin());
+    it = actual.Erase(std::next(actual.Begin(), 2), std::next(actual.Begin(), 5));
+    ASSERT_EQ(*it, 6);
+    expected.erase(std::next(expected.begin(), 2), std::next(expected.begin(), 5));
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+
+    it = actual.Erase(actual.Begin(), actual.End());
+    ASSERT_EQ(it, actual.End());
+    ASSERT_TRUE(actual.Empty());
+}
+
+TEST(Splice, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<int> alloc(stats);
+    task::List<int, CustomAllocator<int>> actual(alloc);
+    task::List<int, CustomAllocator<int>> other(alloc);
+    std::list<int> expected;
+    std::list<int> expected_other;
+    for (int i = 0; i < 5; ++i) {
+        actual.PushBack(i);
+        expected.push_back(i);
+        other.PushBack(10 + i);
+        expected_other.push_back(10 + i);
+    }
+    uint64_t allocations = stats->Collect().allocations;
+
+    actual.Splice(std::next(actual.Begin()), other, std::next(other.Begin()));
+    expected.splice(std::next(expected.begin()), expected_other, std::next(expected_other.begin()));
+    actual.Splice(actual.End(), other, other.Begin(), std::prev(other.End()));
+    expected.splice(expected.end(), expected_other, expected_other.begin(),
+                    std::prev(expected_other.end()));
+    actual.Splice(actual.Begin(), actual, std::next(actual.Begin(), 3), actual.End());
+    expected.splice(expected.begin(), expected, std::next(expected.begin(), 3), expected.end());
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_EQ(other.Size(), expected_other.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+
+    actual.Splice(actual.Begin(), other);
+    expected.splice(expected.begin(), expected_other);
+    ASSERT_TRUE(other.Empty());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+    ASSERT_EQ(stats->Collect().allocations, allocations);
+}
+
+TEST(Merge, Test1) {
+    std::mt19937 random_engine(3);
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::pair<int, int>> alloc(stats);
+    task::List<std::pair<int, int>, CustomAllocator<std::pair<int, int>>> actual(alloc);
+    task::List<std::pair<int, int>, CustomAllocator<std::pair<int, int>>> other(alloc);
+    std::list<std::pair<int, int>> expected;
+    std::list<std::pair<int, int>> expected_other;
+    for (int i = 0; i < 1000; ++i) {
+        std::pair<int, int> value(static_cast<int>(random_engine() % 100), i);
+        if (random_engine() % 2 == 0) {
+            actual.PushBack(value);
+            expected.push_back(value);
+        } else {
+            other.PushBack(value);
+            expected_other.push_back(value);
+        }
+    }
+    auto by_key = [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; };
+    actual.Sort();
+    other.Sort();
+    expected.sort();
+    expected_other.sort();
+    uint64_t allocations = stats->Collect().allocations;
+
+    actual.Merge(other, by_key);
+    expected.merge(expected_other, by_key);
+    ASSERT_TRUE(other.Empty());
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_EQ(stats->Collect().allocations, allocations);
+}
+
+TEST(Compact, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc(stats);
+    task::List<std::string, CustomAllocator<std::string>> actual(alloc);
+    std::mt19937 random_engine(5);
+    for (std::size_t i = 0; i < 10000; i++) {
+        actual.PushBack(std::to_string(random_engine()));
+    }
+    // Sorting relinks the nodes, so traversal order no longer follows their addresses.
+    actual.Sort();
+    std::vector<std::string> expected(actual.Begin(), actual.End());
+    uint64_t live_bytes = stats->Collect().live_bytes;
+
+    actual.Compact();
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+    ASSERT_TRUE(std::is_sorted(actual.Begin(), actual.End(), [](const auto& lhs, const auto& rhs) {
+        return std::less<const std::string*>()(&lhs, &rhs);
+    }));
+    ASSERT_EQ(stats->Collect().live_bytes, live_bytes);
+}
+
+TEST(Unique, Test2) {
+    // Long runs of equal values make the prefetch lookahead reach nodes that are being erased.
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        for (int j = 0; j < i % 13; ++j) {
+            actual.PushBack(i / 7);
+            expected.push_back(i / 7);
+        }
+    }
+    actual.Unique();
+    expected.unique();
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+TEST(Prefetch, Test1) {
+    for (std::size_t size : {0, 1, 3, 4, 5, 100}) {
+        task::List<std::string, CustomAllocator<std::string>> list;
+        for (std::size_t i = 0; i < size; ++i) {
+            list.PushBack(std::to_string(i));
+        }
+        std::vector<std::string> actual;
+        for (std::string& value : task::Prefetched(list)) {
+            actual.push_back(value);
+            value += "!";
+        }
+        ASSERT_TRUE(std::equal(actual.begin(), actual.end(), list.Begin(), list.End(),
+                               [](const std::string& lhs, const std::string& rhs) {
+                                   return lhs + "!" == rhs;
+                               }));
+
+        const auto& const_list = list;
+        auto range = task::Prefetched<1>(const_list);
+        ASSERT_EQ(static_cast<std::size_t>(std::distance(range.begin(), range.end())), size);
+    }
+}
+
+TEST(RemoveIf, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc(stats);
+    task::List<std::string, CustomAllocator<std::string>> actual(alloc);
+    std::list<std::string> expected;
+    for (std::size_t i = 0; i < 1000; i++) {
+        actual.PushBack(std::to_string(i % 10));
+        expected.push_back(std::to_string(i % 10));
+    }
+    auto odd = [](const std::string& value) { return (value.back() - '0') % 2 == 1; };
+    ASSERT_EQ(actual.RemoveIf(odd), 500);
+    expected.remove_if(odd);
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_EQ(stats->Collect().deallocations, 500);
+
+    // The value refers to the first element, which is among the removed ones.
+    actual.Remove(actual.Front());
+    expected.remove("0");
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+TEST(RemoveDuplicates, Test1) {
+    std::mt19937 random_engine(11);
+    task::List<std::string, CustomAllocator<std::string>> actual;
+    std::vector<std::string> expected;
+    std::unordered_set<std::string> seen;
+    for (std::size_t i = 0; i < 10000; i++) {
+        std::string value = std::to_string(random_engine() % 3000);
+        actual.PushBack(value);
+        if (seen.insert(value).second) {
+            expected.push_back(value);
+        }
+    }
+    ASSERT_EQ(actual.RemoveDuplicates(), 10000 - expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_EQ(actual.RemoveDuplicates(), 0);
+
+    // Every hash collides, so all of the work falls on probing and KeyEqual.
+    task::List<int> colliding;
+    for (int i = 0; i < 200; ++i) {
+        colliding.PushBack(i % 50);
+    }
+    ASSERT_EQ(colliding.RemoveDuplicates([](int) { return std::size_t{0}; }), 150);
+    ASSERT_EQ(colliding.Size(), 50);
+    ASSERT_EQ(colliding.Back(), 49);
+}
+
 TEST(Mixed, Test1) {
     task::List<std::string, CustomAllocator<std::string>> actual;
     std::list<std::string, CustomAllocator<std::string>> expected;
@@ -259,6 +687,585 @@ TEST(Mixed, Test1) {
     ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
 }
 
+TEST(AllocatorStats, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    {
+        CustomAllocator<std::string> alloc(stats);
+        std::list<std::string, CustomAllocator<std::string>> expected(alloc);
+        for (std::size_t i = 0; i < 10; i++) {
+            expected.push_back("hello");
+        }
+        ASSERT_GT(stats->Collect().live_bytes, 0);
+    }
+    AllocatorStats::Snapshot snapshot = stats->Collect();
+    ASSERT_EQ(snapshot.allocations, 10);
+    ASSERT_EQ(snapshot.deallocations, 10);
+    ASSERT_EQ(snapshot.live_bytes, 0);
+    ASSERT_GT(snapshot.peak_bytes, 0);
+}
+
+TEST(AllocatorStats, Test2) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc(stats);
+    std::list<std::string, CustomAllocator<std::string>> expected(alloc);
+    {
+        AllocatorStats::ScopedCallSite site("fill");
+        for (std::size_t i = 0; i < 10; i++) {
+            expected.push_back("hello");
+        }
+    }
+    expected.clear();
+    for (std::size_t i = 0; i < 10; i++) {
+        expected.push_back("world");
+    }
+
+    AllocatorStats::Snapshot snapshot = stats->Collect();
+    ASSERT_EQ(snapshot.pool_hits, 10);
+    ASSERT_EQ(snapshot.pool_misses, 10);
+    ASSERT_EQ(snapshot.call_sites.size(), 1);
+    ASSERT_STREQ(snapshot.call_sites[0].name, "fill");
+    ASSERT_EQ(snapshot.call_sites[0].allocations, 10);
+}
+
+TEST(MemoryResource, Test1) {
+    PoolResource pool;
+    ArenaResource arena;
+    MallocResource heap;
+    using PmrList = std::list<std::string, PolymorphicAllocator<std::string>>;
+    std::vector<PmrList> lists;
+    lists.emplace_back(PolymorphicAllocator<std::string>(&pool));
+    lists.emplace_back(PolymorphicAllocator<std::string>(&arena));
+    lists.emplace_back(PolymorphicAllocator<std::string>(&heap));
+
+    for (PmrList& list : lists) {
+        for (std::size_t i = 0; i < 10; i++) {
+            list.push_back("hello");
+        }
+        list.pop_front();
+        list.push_front("world");
+    }
+    ASSERT_TRUE(std::equal(lists[0].begin(), lists[0].end(), lists[1].begin(), lists[1].end()));
+    ASSERT_TRUE(std::equal(lists[0].begin(), lists[0].end(), lists[2].begin(), lists[2].end()));
+}
+
+TEST(MemoryResource, Test2) {
+    auto stats = std::make_shared<AllocatorStats>();
+    PoolResource pool;
+    InstrumentedResource instrumented(&pool, stats);
+    {
+        PolymorphicAllocator<int> alloc(&instrumented);
+        std::list<int, PolymorphicAllocator<int>> list(alloc);
+        for (int i = 0; i < 10; i++) {
+            list.push_back(i);
+        }
+    }
+    AllocatorStats::Snapshot snapshot = stats->Collect();
+    ASSERT_EQ(snapshot.allocations, 10);
+    ASSERT_EQ(snapshot.live_bytes, 0);
+    ASSERT_TRUE(PolymorphicAllocator<int>(&instrumented) != PolymorphicAllocator<int>(&pool));
+    ASSERT_TRUE(PolymorphicAllocator<int>(&pool) != PolymorphicAllocator<int>(&instrumented));
+    {
+        // Sharing the pool does not let the instrumented list adopt the plain list's nodes.
+        task::List<int, PolymorphicAllocator<int>> plain(PolymorphicAllocator<int>{&pool});
+        for (int i = 0; i < 10; i++) {
+            plain.PushBack(i);
+        }
+        task::List<int, PolymorphicAllocator<int>> counted(PolymorphicAllocator<int>{&instrumented});
+        counted = std::move(plain);
+        ASSERT_EQ(stats->Collect().allocations, 20);
+    }
+    ASSERT_EQ(stats->Collect().live_bytes, 0);
+    ASSERT_TRUE(PolymorphicAllocator<int>(&pool) != PolymorphicAllocator<int>());
+
+    // An arena built with no initial block still grows.
+    ArenaResource arena(0);
+    std::vector<int, PolymorphicAllocator<int>> vector{PolymorphicAllocator<int>(&arena)};
+    vector.assign(1000, 7);
+    ASSERT_EQ(vector.back(), 7);
+}
+
+TEST(ChunkSource, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    auto pool = std::make_shared<Pool>(
+        stats, ChunkSource(ChunkSource::Backing::kMmap, ChunkSource::kDefaultChunkSize, true));
+    pool->Reserve(1);
+    CustomAllocator<std::string> alloc(pool);
+    std::list<std::string, CustomAllocator<std::string>> actual(alloc);
+    std::list<std::string> expected;
+
+    for (std::size_t i = 0; i < 100000; i++) {
+        actual.push_back("hello");
+        expected.push_back("hello");
+    }
+    ASSERT_TRUE(std::equal(actual.begin(), actual.end(), expected.begin(), expected.end()));
+    ASSERT_EQ(stats->Collect().chunk_bytes % ChunkSource::kHugePageSize, 0);
+}
+
+TEST(ChunkSource, Test2) {
+    ChunkSource source(ChunkSource::Backing::kHugePages);
+    void* chunk = source.Allocate();
+    ASSERT_NE(source.EffectiveBacking(), ChunkSource::Backing::kHeap);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(chunk) % ChunkSource::kHugePageSize, 0);
+    std::fill_n(static_cast<char*>(chunk), source.ChunkSize(), 'x');
+    source.Release(chunk);
+}
+
+// Chunk sizes too small for the largest pooled request are raised, so carving stays in bounds.
+TEST(ChunkSource, Test3) {
+    ASSERT_EQ(ChunkSource(ChunkSource::Backing::kHeap, 0).ChunkSize(), ChunkSource::kMinChunkSize);
+    auto stats = std::make_shared<AllocatorStats>();
+    Pool pool(stats, ChunkSource(ChunkSource::Backing::kHeap, 16));
+    pool.Reserve(Pool::kMaxPooledSize);
+    std::vector<void*> blocks;
+    for (std::size_t i = 0; i < 100; i++) {
+        blocks.push_back(pool.Allocate(Pool::kMaxPooledSize));
+        std::fill_n(static_cast<char*>(blocks.back()), Pool::kMaxPooledSize, 'x');
+    }
+    for (void* block : blocks) {
+        pool.Deallocate(block, Pool::kMaxPooledSize);
+    }
+    ASSERT_EQ(stats->Collect().chunk_bytes % ChunkSource::kMinChunkSize, 0);
+}
+
+TEST(UnrolledList, Test1) {
+    task::UnrolledList<std::string, CustomAllocator<std::string>> actual;
+    std::list<std::string> expected;
+    for (std::size_t i = 0; i < 1000; i++) {
+        std::string value = std::to_string(i);
+        if (i % 3 == 0) {
+            actual.PushFront(value);
+            expected.push_front(value);
+        } else {
+            actual.PushBack(value);
+            expected.push_back(value);
+        }
+        if (i % 7 == 0) {
+            actual.PopBack();
+            expected.pop_back();
+        }
+        if (i % 11 == 0 && !expected.empty()) {
+            actual.PopFront();
+            expected.pop_front();
+        }
+    }
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+}
+
+TEST(UnrolledList, Test2) {
+    auto stats = std::make_shared<AllocatorStats>();
+    CustomAllocator<std::string> alloc(stats);
+    task::UnrolledList<std::string, CustomAllocator<std::string>> actual(alloc);
+    std::list<std::string> expected;
+    for (std::size_t i = 0; i < 1000; i++) {
+        std::string value = std::to_string(i % 5);
+        actual.PushBack(value);
+        expected.push_back(value);
+    }
+    ASSERT_LE(stats->Collect().allocations, 1000 / decltype(actual)::kNodeCapacity + 1);
+
+    // The argument aliases an element that is itself removed.
+    actual.Remove(*std::next(actual.Begin(), 3));
+    expected.remove("3");
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+
+    actual.Sort();
+    expected.sort();
+    actual.Unique();
+    expected.unique();
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+
+    actual.Remove("0");
+    actual.Remove("1");
+    actual.Remove("2");
+    actual.Remove("4");
+    ASSERT_TRUE(actual.Empty());
+    ASSERT_EQ(stats->Collect().live_bytes, 0);
+}
+
+TEST(UnrolledList, Test3) {
+    task::UnrolledList<std::string, CustomAllocator<std::string>> actual;
+    for (std::size_t i = 0; i < 100; i++) {
+        actual.PushBack("hello");
+    }
+    task::UnrolledList<std::string, CustomAllocator<std::string>> copy(actual);
+    task::UnrolledList<std::string, CustomAllocator<std::string>> moved(std::move(actual));
+    ASSERT_TRUE(actual.Empty());
+    ASSERT_EQ(moved.Size(), 100);
+    ASSERT_TRUE(std::equal(copy.Begin(), copy.End(), moved.Begin(), moved.End()));
+
+    actual = copy;
+    copy = std::move(moved);
+    actual.Swap(copy);
+    ASSERT_TRUE(moved.Empty());
+    ASSERT_TRUE(std::equal(copy.Begin(), copy.End(), actual.Begin(), actual.End()));
+}
+
+namespace {
+
+// Counts live instances; operator== throws once `budget` comparisons have been made.
+struct FragileValue {
+    static int live;
+    static int budget;
+
+    explicit FragileValue(int key) : key(std::to_string(key)) {
+        ++live;
+    }
+    FragileValue(const FragileValue& other) : key(other.key) {
+        ++live;
+    }
+    FragileValue(FragileValue&& other) noexcept : key(std::move(other.key)) {
+        ++live;
+    }
+    ~FragileValue() {
+        --live;
+    }
+
+    bool operator==(const FragileValue& other) const {
+        if (budget-- == 0) {
+            throw std::runtime_error("comparison failed");
+        }
+        return key == other.key;
+    }
+
+    std::string key;
+};
+
+int FragileValue::live = 0;
+int FragileValue::budget = 0;
+
+}  // namespace
+
+// A throwing comparison in Remove or Unique leaves a whole list: no element is lost to a gap or
+// destroyed twice, and Size() matches what iteration sees.
+TEST(UnrolledList, Test4) {
+    for (int budget : {0, 1, 10, 40, 70, 150, 390}) {
+        for (bool unique : {false, true}) {
+            {
+                task::UnrolledList<FragileValue> list;
+                for (int i = 0; i < 400; i++) {
+                    list.PushBack(FragileValue(i % 7 == 0 || i % 5 == 0 ? 0 : i / 3));
+                }
+                FragileValue::budget = budget;
+                if (unique) {
+                    ASSERT_THROW(list.Unique(), std::runtime_error);
+                } else {
+                    ASSERT_THROW(list.Remove(FragileValue(0)), std::runtime_error);
+                }
+                FragileValue::budget = -1;
+                ASSERT_EQ(static_cast<std::size_t>(std::distance(list.Begin(), list.End())),
+                          list.Size());
+                ASSERT_EQ(static_cast<std::size_t>(FragileValue::live), list.Size());
+                ASSERT_LE(list.Size(), 400);
+                list.Unique();
+                list.PushBack(FragileValue(1));
+            }
+            ASSERT_EQ(FragileValue::live, 0);
+        }
+    }
+}
+
+namespace {
+
+struct Item : task::IntrusiveListHook<>, task::IntrusiveListHook<struct ByAge> {
+    Item(std::string name, int age) : name(std::move(name)), age(age) {
+    }
+    std::string name;
+    int age;
+};
+
+}  // namespace
+
+TEST(IntrusiveList, Test1) {
+    std::vector<Item> items;
+    for (int i = 0; i < 100; i++) {
+        items.emplace_back(std::to_string(i), i % 10);
+    }
+    task::IntrusiveList<Item> actual;
+    std::list<Item*> expected;
+    for (std::size_t i = 0; i < items.size(); i++) {
+        if (i % 3 == 0) {
+            actual.PushFront(items[i]);
+            expected.push_front(&items[i]);
+        } else {
+            actual.PushBack(items[i]);
+            expected.push_back(&items[i]);
+        }
+    }
+    actual.PopFront();
+    expected.pop_front();
+    actual.PopBack();
+    expected.pop_back();
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_EQ(&actual.Front(), expected.front());
+    ASSERT_EQ(&actual.Back(), expected.back());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end(),
+                           [](const Item& lhs, const Item* rhs) { return &lhs == rhs; }));
+
+    // Unlinking by reference is O(1) and leaves the object free to join another list.
+    actual.Erase(task::IntrusiveList<Item>::IteratorTo(items[50]));
+    expected.remove(&items[50]);
+    ASSERT_FALSE(items[50].task::IntrusiveListHook<>::IsLinked());
+    ASSERT_EQ(actual.Size(), expected.size());
+    actual.Clear();
+    ASSERT_TRUE(actual.Empty());
+    ASSERT_FALSE(items[0].task::IntrusiveListHook<>::IsLinked());
+}
+
+TEST(IntrusiveList, Test2) {
+    std::vector<Item> items;
+    for (int i = 0; i < 1000; i++) {
+        items.emplace_back(std::to_string(i), (i * 7919) % 100);
+    }
+    task::IntrusiveList<Item> by_name;
+    task::IntrusiveList<Item, ByAge> by_age;
+    for (Item& item : items) {
+        by_name.PushBack(item);
+        by_age.PushBack(item);
+    }
+
+    // Both lists thread the same objects; sorting one does not disturb the other.
+    by_age.Sort([](const Item& lhs, const Item& rhs) { return lhs.age < rhs.age; });
+    std::vector<Item*> expected;
+    for (Item& item : items) {
+        expected.push_back(&item);
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const Item* lhs, const Item* rhs) { return lhs->age < rhs->age; });
+    auto same = [](const Item& lhs, const Item* rhs) { return &lhs == rhs; };
+    ASSERT_TRUE(std::equal(by_age.Begin(), by_age.End(), expected.begin(), expected.end(), same));
+    ASSERT_EQ(&by_name.Front(), &items.front());
+    ASSERT_EQ(&by_name.Back(), &items.back());
+
+    task::IntrusiveList<Item, ByAge> young;
+    auto split = std::find_if(by_age.Begin(), by_age.End(),
+                              [](const Item& item) { return item.age >= 50; });
+    young.Splice(young.End(), by_age, by_age.Begin(), split);
+    ASSERT_EQ(young.Size() + by_age.Size(), items.size());
+    ASSERT_LT(young.Back().age, 50);
+    ASSERT_GE(by_age.Front().age, 50);
+
+    young.Splice(young.End(), by_age);
+    ASSERT_TRUE(by_age.Empty());
+    ASSERT_TRUE(std::equal(young.Begin(), young.End(), expected.begin(), expected.end(), same));
+
+    task::IntrusiveList<Item, ByAge> moved(std::move(young));
+    moved.Swap(by_age);
+    ASSERT_TRUE(moved.Empty());
+    ASSERT_EQ(by_age.Size(), items.size());
+    by_age.Clear();
+    by_name.Clear();
+}
+
+// A throwing comparison leaves every object on the list, linked in both directions.
+TEST(IntrusiveList, Test3) {
+    std::vector<Item> items;
+    for (int i = 0; i < 1000; i++) {
+        items.emplace_back(std::to_string(i), (i * 7919) % 100);
+    }
+    for (int budget : {0, 1, 500, 5000}) {
+        task::IntrusiveList<Item, ByAge> by_age;
+        for (Item& item : items) {
+            by_age.PushBack(item);
+        }
+        int comparisons = 0;
+        auto fragile = [&comparisons, budget](const Item& lhs, const Item& rhs) {
+            if (comparisons++ == budget) {
+                throw std::runtime_error("comparison failed");
+            }
+            return lhs.age < rhs.age;
+        };
+        ASSERT_THROW(by_age.Sort(fragile), std::runtime_error);
+
+        std::vector<const Item*> forward;
+        for (auto it = by_age.Begin(); it != by_age.End(); ++it) {
+            forward.push_back(&*it);
+        }
+        std::vector<const Item*> backward;
+        for (auto it = by_age.End(); it != by_age.Begin();) {
+            backward.push_back(&*--it);
+        }
+        ASSERT_EQ(by_age.Size(), items.size());
+        ASSERT_TRUE(std::equal(forward.begin(), forward.end(), backward.rbegin(), backward.rend()));
+        std::sort(forward.begin(), forward.end());
+        ASSERT_TRUE(std::adjacent_find(forward.begin(), forward.end()) == forward.end());
+        ASSERT_EQ(forward.size(), items.size());
+        by_age.Clear();
+    }
+}
+
+TEST(MpmcQueue, Test1) {
+    auto stats = std::make_shared<AllocatorStats>();
+    {
+        task::MpmcQueue<std::string, CustomAllocator<std::string>> queue(
+            CustomAllocator<std::string>{stats});
+        ASSERT_TRUE(queue.Empty());
+        ASSERT_FALSE(queue.TryPop().has_value());
+        for (std::size_t round = 0; round < 10; round++) {
+            for (std::size_t i = 0; i < 1000; i++) {
+                queue.Push(std::to_string(i));
+            }
+            for (std::size_t i = 0; i < 1000; i++) {
+                std::optional<std::string> value = queue.TryPop();
+                ASSERT_TRUE(value.has_value());
+                ASSERT_EQ(*value, std::to_string(i));
+            }
+        }
+        ASSERT_TRUE(queue.Empty());
+        // Popped nodes are recycled, so later rounds allocate nothing new.
+        ASSERT_LE(stats->Collect().allocations, 16);
+        queue.Emplace(3, 'x');
+    }
+    ASSERT_EQ(stats->Collect().live_bytes, 0);
+}
+
+namespace {
+
+// Producers push (producer, sequence) pairs; every consumer must see each producer's values in
+// order, and every value must come out exactly once.
+template <typename Queue>
+void CheckConcurrentQueue(Queue& queue, std::size_t producers, std::size_t consumers) {
+    constexpr std::size_t kPerProducer = 20000;
+    const std::size_t total = producers * kPerProducer;
+    std::atomic<std::size_t> popped{0};
+    std::vector<std::vector<std::size_t>> received(consumers);
+
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p] {
+            for (std::size_t i = 0; i < kPerProducer; i++) {
+                queue.Push(p * kPerProducer + i);
+            }
+        });
+    }
+    for (std::size_t c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            while (popped.load() < total) {
+                if (std::optional<std::size_t> value = queue.TryPop()) {
+                    received[c].push_back(*value);
+                    popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<char> seen(total, 0);
+    for (const std::vector<std::size_t>& values : received) {
+        std::vector<std::size_t> last(producers, 0);
+        for (std::size_t value : values) {
+            std::size_t producer = value / kPerProducer;
+            ASSERT_GE(value + 1, last[producer]);
+            last[producer] = value + 1;
+            ASSERT_EQ(seen[value]++, 0);
+        }
+    }
+    ASSERT_EQ(std::count(seen.begin(), seen.end(), 1), total);
+    ASSERT_TRUE(queue.Empty());
+}
+
+}  // namespace
+
+TEST(MpmcQueue, Test2) {
+    task::MpmcQueue<std::size_t, CustomAllocator<std::size_t>> queue;
+    CheckConcurrentQueue(queue, 4, 4);
+    CheckConcurrentQueue(queue, 1, 3);
+}
+
+// Consumers stop once the producers are done and the queue is drained, so a lost element shows
+// up as a short count rather than a hang. Tails are retired while producers may still hold them.
+TEST(MpmcQueue, Test3) {
+    constexpr std::size_t kProducers = 4;
+    constexpr std::size_t kConsumers = 2;
+    constexpr std::size_t kPerProducer = 20000;
+    task::MpmcQueue<std::size_t> queue;
+    for (std::size_t round = 0; round < 10; round++) {
+        std::atomic<std::size_t> producing{kProducers};
+        std::atomic<std::size_t> popped{0};
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < kProducers; p++) {
+            threads.emplace_back([&] {
+                for (std::size_t i = 0; i < kPerProducer; i++) {
+                    queue.Push(i);
+                }
+                producing.fetch_sub(1);
+            });
+        }
+        for (std::size_t c = 0; c < kConsumers; c++) {
+            threads.emplace_back([&] {
+                for (;;) {
+                    bool done = producing.load() == 0;
+                    if (queue.TryPop().has_value()) {
+                        popped.fetch_add(1);
+                    } else if (done) {
+                        return;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(popped.load(), kProducers * kPerProducer);
+        ASSERT_TRUE(queue.Empty());
+    }
+}
+
+namespace {
+
+struct ThrowingValue {
+    explicit ThrowingValue(int value) : value(value) {
+        if (value < 0) {
+            throw std::invalid_argument("negative");
+        }
+    }
+
+    int value;
+};
+
+}  // namespace
+
+// A value whose construction throws hands its node back to the pool.
+TEST(MpmcQueue, Test4) {
+    auto stats = std::make_shared<AllocatorStats>();
+    {
+        task::MpmcQueue<ThrowingValue, CustomAllocator<ThrowingValue>> mpmc(
+            CustomAllocator<ThrowingValue>{stats});
+        task::MpscQueue<ThrowingValue, CustomAllocator<ThrowingValue>> mpsc(
+            CustomAllocator<ThrowingValue>{stats});
+        std::size_t allocations = stats->Collect().allocations;
+        for (std::size_t i = 0; i < 1000; i++) {
+            ASSERT_THROW(mpmc.Emplace(-1), std::invalid_argument);
+            ASSERT_THROW(mpsc.Emplace(-1), std::invalid_argument);
+        }
+        ASSERT_EQ(stats->Collect().allocations, allocations);
+        mpmc.Emplace(1);
+        mpsc.Emplace(2);
+        ASSERT_EQ(mpmc.TryPop()->value, 1);
+        ASSERT_EQ(mpsc.TryPop()->value, 2);
+    }
+    ASSERT_EQ(stats->Collect().live_bytes, 0);
+}
+
+TEST(MpscQueue, Test1) {
+    task::MpscQueue<std::size_t, CustomAllocator<std::size_t>> queue;
+    CheckConcurrentQueue(queue, 4, 1);
+
+    task::MpscQueue<std::string> strings;
+    strings.Push("hello");
+    strings.Push("world");
+    ASSERT_EQ(*strings.TryPop(), "hello");
+    ASSERT_FALSE(strings.Empty());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
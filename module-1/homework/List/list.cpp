@@ -1,3 +1,335 @@
 #include "list.h"
 
-// Your code goes here...
\ No newline at end of file
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+
+namespace task {
+
+
+const size_t list::kMinSlabNodes;
+
+list::list() {
+    reset();
+}
+
+list::list(size_t count, const int& value) : list() {
+    append_nodes(count, value);
+}
+
+list::list(const list& other) : list() {
+    if (other.size_ == 0) {
+        return;
+    }
+    node* n = carve_nodes(other.size_);
+    node_base* tail = &head_;
+    for (const node_base* o = other.head_.next; o != &other.head_; o = o->next, ++n) {
+        n->value = value_of(o);
+        n->prev = tail;
+        tail->next = n;
+        tail = n;
+    }
+    tail->next = &head_;
+    head_.prev = tail;
+    size_ = other.size_;
+}
+
+list::~list() {
+    release_slabs();
+}
+
+list& list::operator=(const list& other) {
+    if (this != &other) {
+        list copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+
+int& list::front() {
+    return value_of(head_.next);
+}
+
+const int& list::front() const {
+    return value_of(head_.next);
+}
+
+int& list::back() {
+    return value_of(head_.prev);
+}
+
+const int& list::back() const {
+    return value_of(head_.prev);
+}
+
+
+bool list::empty() const {
+    return size_ == 0;
+}
+
+size_t list::size() const {
+    return size_;
+}
+
+// Releases whole slabs instead of visiting every node.
+void list::clear() {
+    release_slabs();
+    free_nodes_ = nullptr;
+    slab_cur_ = nullptr;
+    slab_end_ = nullptr;
+    reset();
+}
+
+
+void list::push_back(const int& value) {
+    insert_before(&head_, value);
+}
+
+void list::pop_back() {
+    erase(head_.prev);
+}
+
+void list::push_front(const int& value) {
+    insert_before(head_.next, value);
+}
+
+void list::pop_front() {
+    erase(head_.next);
+}
+
+void list::resize(size_t count) {
+    while (size_ > count) {
+        pop_back();
+    }
+    if (size_ < count) {
+        append_nodes(count - size_, int());
+    }
+}
+
+void list::swap(list& other) {
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    std::swap(free_nodes_, other.free_nodes_);
+    std::swap(slab_cur_, other.slab_cur_);
+    std::swap(slab_end_, other.slab_end_);
+    std::swap(slabs_, other.slabs_);
+    for (list* l : {this, &other}) {
+        if (l->size_ == 0) {
+            l->reset();
+        } else {
+            l->head_.next->prev = &l->head_;
+            l->head_.prev->next = &l->head_;
+        }
+    }
+}
+
+
+void list::remove(const int& value) {
+    // `value` may refer to an element of this list, so compare against a copy.
+    const int copy = value;
+    node_base* n = head_.next;
+    while (n != &head_) {
+        node_base* next = n->next;
+        if (value_of(n) == copy) {
+            erase(n);
+        }
+        n = next;
+    }
+}
+
+void list::unique() {
+    if (size_ < 2) {
+        return;
+    }
+    node_base* n = head_.next;
+    while (n->next != &head_) {
+        if (value_of(n) == value_of(n->next)) {
+            erase(n->next);
+        } else {
+            n = n->next;
+        }
+    }
+}
+
+// Merge sort on the `next` chain, then one pass to restore `prev`. Only relinks nodes.
+void list::sort() {
+    if (size_ < 2) {
+        return;
+    }
+    head_.prev->next = nullptr;
+    node_base* first = merge_sort(head_.next);
+
+    node_base* prev = &head_;
+    for (node_base* n = first; n != nullptr; n = n->next) {
+        n->prev = prev;
+        prev->next = n;
+        prev = n;
+    }
+    prev->next = &head_;
+    head_.prev = prev;
+}
+
+
+// Bottom-up natural merge sort. Runs go into binary-counter bins (bins[i] holds 2^i merged runs),
+// so merges stay on recently touched nodes; sorted input is one run and costs a single scan.
+list::node_base* list::merge_sort(node_base* first) {
+    const size_t kBins = 64;
+    node_base* bins[kBins] = {};
+    size_t used = 0;
+    while (first != nullptr) {
+        node_base* run = first;
+        node_base* last = run_end(run);
+        first = last->next;
+        last->next = nullptr;
+
+        // older runs stay on the left, which keeps the sort stable
+        size_t bin = 0;
+        for (; bin < used && bins[bin] != nullptr; ++bin) {
+            run = merge_runs(bins[bin], run);
+            bins[bin] = nullptr;
+        }
+        bins[bin] = run;
+        used = std::max(used, bin + 1);
+    }
+
+    node_base* result = nullptr;
+    for (size_t bin = 0; bin < used; ++bin) {
+        if (bins[bin] != nullptr) {
+            result = result == nullptr ? bins[bin] : merge_runs(bins[bin], result);
+        }
+    }
+    return result;
+}
+
+list::node_base* list::run_end(node_base* first) {
+    node_base* last = first;
+    while (last->next != nullptr && value_of(last) <= value_of(last->next)) {
+        last = last->next;
+    }
+    return last;
+}
+
+list::node_base* list::merge_runs(node_base* lhs, node_base* rhs) {
+    node_base merged{nullptr, nullptr};
+    node_base* tail = &merged;
+    while (lhs != nullptr && rhs != nullptr) {
+        if (value_of(rhs) < value_of(lhs)) {
+            tail->next = rhs;
+            rhs = rhs->next;
+        } else {
+            tail->next = lhs;
+            lhs = lhs->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = lhs != nullptr ? lhs : rhs;
+    return merged.next;
+}
+
+int& list::value_of(node_base* n) {
+    return static_cast<node*>(n)->value;
+}
+
+const int& list::value_of(const node_base* n) {
+    return static_cast<const node*>(n)->value;
+}
+
+void list::insert_before(node_base* pos, const int& value) {
+    node* n = allocate_node();
+    n->value = value;
+    n->next = pos;
+    n->prev = pos->prev;
+    pos->prev->next = n;
+    pos->prev = n;
+    ++size_;
+}
+
+void list::erase(node_base* n) {
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->next = free_nodes_;
+    free_nodes_ = n;
+    --size_;
+}
+
+list::node* list::allocate_node() {
+    if (free_nodes_ != nullptr) {
+        node_base* n = free_nodes_;
+        free_nodes_ = n->next;
+        return static_cast<node*>(n);
+    }
+    // Slabs grow with the list, so n push_backs take O(log n) allocations.
+    return carve_nodes(1);
+}
+
+// Returns `count` consecutive nodes, starting a new slab (in one allocation) if the current one
+// is too short. What is left of the old slab goes onto the free list.
+list::node* list::carve_nodes(size_t count) {
+    if (static_cast<size_t>(slab_end_ - slab_cur_) < count) {
+        for (; slab_cur_ != slab_end_; ++slab_cur_) {
+            slab_cur_->next = free_nodes_;
+            free_nodes_ = slab_cur_;
+        }
+        size_t slab_nodes = std::max(count, std::max(kMinSlabNodes, size_));
+        node* slab = new node[slab_nodes + 1];
+        slab->next = slabs_;
+        slabs_ = slab;
+        slab_cur_ = slab + 1;
+        slab_end_ = slab_cur_ + slab_nodes;
+    }
+    node* first = slab_cur_;
+    slab_cur_ += count;
+    return first;
+}
+
+// Appends `count` copies of `value`: free nodes are reused first, the rest come from a single
+// carve and are linked in one pass. The carve, the only step that can throw, comes before any
+// node is linked, so a failed append leaves the list as it was.
+void list::append_nodes(size_t count, const int& value) {
+    size_t reused = 0;
+    for (node_base* n = free_nodes_; reused < count && n != nullptr; n = n->next) {
+        ++reused;
+    }
+    size_t remaining = count - reused;
+    node* carved = remaining > 0 ? carve_nodes(remaining) : nullptr;
+
+    node_base* tail = head_.prev;
+    for (; reused > 0; --reused) {
+        node_base* n = free_nodes_;
+        free_nodes_ = n->next;
+        static_cast<node*>(n)->value = value;
+        n->prev = tail;
+        tail->next = n;
+        tail = n;
+    }
+    if (remaining > 0) {
+        node* n = carved;
+        for (node* end = n + remaining; n != end; ++n) {
+            n->value = value;
+            n->prev = tail;
+            tail->next = n;
+            tail = n;
+        }
+    }
+    tail->next = &head_;
+    head_.prev = tail;
+    size_ += count;
+}
+
+void list::release_slabs() {
+    while (slabs_ != nullptr) {
+        node* next = static_cast<node*>(slabs_->next);
+        delete[] slabs_;
+        slabs_ = next;
+    }
+}
+
+void list::reset() {
+    head_.prev = &head_;
+    head_.next = &head_;
+    size_ = 0;
+}
+
+}  // namespace task
@@ -11,6 +11,7 @@ public:
 
     list();
     list(size_t count, const int& value = int());
+    list(const list& other);
 
     ~list();
     list& operator=(const list& other);
@@ -40,11 +41,44 @@ public:
     void unique();
     void sort();
 
-    // Your code goes here?..
-
 private:
 
-    // Your code goes here...
+    struct node_base {
+        node_base* prev;
+        node_base* next;
+    };
+
+    struct node : node_base {
+        int value;
+    };
+
+    static int& value_of(node_base* n);
+    static const int& value_of(const node_base* n);
+
+    static node_base* merge_sort(node_base* first);
+    static node_base* run_end(node_base* first);
+    static node_base* merge_runs(node_base* lhs, node_base* rhs);
+
+    void insert_before(node_base* pos, const int& value);
+    void erase(node_base* n);
+    void reset();
+
+    // Nodes are carved from slabs owned by the list. Erased nodes go onto free_nodes_ for reuse,
+    // and all slabs are released at once by clear() and the destructor.
+    static const size_t kMinSlabNodes = 64;
+
+    node* allocate_node();
+    node* carve_nodes(size_t count);
+    void append_nodes(size_t count, const int& value);
+    void release_slabs();
+
+    node_base head_;
+    size_t size_;
+    node_base* free_nodes_ = nullptr;
+    node* slab_cur_ = nullptr;
+    node* slab_end_ = nullptr;
+    // Slot 0 of every slab is a header whose `next` links to the previous slab.
+    node* slabs_ = nullptr;
 
 };
 
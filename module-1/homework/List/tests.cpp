@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "list.h"
+#include "unrolled_list.h"
 
 size_t RandomUInt(size_t max = -1) {
     static std::mt19937 rand(std::random_device{}());
@@ -161,6 +162,125 @@ int main() {
         ASSERT_EQUAL_MSG(ToStdList(list_task2), list_std2, "list::swap")
     }
 
+    {
+        task::unrolled_list list_task;
+        std::list<int> list_std;
+
+        for (size_t i = 0; i < 3 * task::unrolled_list::kNodeCapacity; ++i) {
+            auto val = RandomUInt(10);
+            if (TossCoin()) {
+                list_task.push_back(val);
+                list_std.push_back(val);
+            } else {
+                list_task.push_front(val);
+                list_std.push_front(val);
+            }
+        }
+
+        ASSERT_EQUAL_MSG(list_task, list_std, "unrolled_list::push")
+        ASSERT_TRUE(std::equal(list_std.rbegin(), list_std.rend(),
+                               std::make_reverse_iterator(list_task.end()),
+                               std::make_reverse_iterator(list_task.begin())))
+
+        list_task.remove(list_task.front());
+        list_std.remove(list_std.front());
+
+        ASSERT_EQUAL_MSG(list_task, list_std, "unrolled_list::remove")
+        ASSERT_TRUE(list_task.size() == list_std.size())
+
+        list_task.sort();
+        list_std.sort();
+        list_task.unique();
+        list_std.unique();
+
+        ASSERT_EQUAL_MSG(list_task, list_std, "unrolled_list::unique")
+
+        task::unrolled_list list_task2(5, 30);
+        list_task.swap(list_task2);
+        ASSERT_TRUE(list_task.size() == 5 && list_task.back() == 30)
+        list_task2 = list_task;
+        ASSERT_EQUAL_MSG(list_task2, list_task, "unrolled_list::operator=")
+    }
+
+    {
+        // bulk construction, resize and teardown against the node-at-a-time std::list
+        task::list list_task(100000, 7);
+        std::list<int> list_std(100000, 7);
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::list(count, value)")
+
+        for (size_t i = 0; i < 1000; ++i) {
+            list_task.pop_back();
+            list_std.pop_back();
+        }
+        list_task.resize(200000);
+        list_std.resize(200000);
+        ASSERT_TRUE(list_task.size() == 200000 && list_task.back() == 0)
+        list_task.push_front(list_task.back());
+        list_std.push_front(list_std.back());
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::resize")
+
+        task::list list_copy = list_task;
+        list_task.clear();
+        ASSERT_TRUE(list_task.empty())
+        list_task.resize(3);
+        list_task.push_back(1);
+        ASSERT_TRUE(list_task.size() == 4 && list_task.front() == 0 && list_task.back() == 1)
+        ASSERT_EQUAL_MSG(ToStdList(list_copy), list_std, "list::list(const list&)")
+    }
+
+    {
+        const size_t LIST_COUNT = 5;
+        const size_t ITER_COUNT = 30000;
+
+        std::vector<task::unrolled_list> lists_task(LIST_COUNT);
+        std::vector<std::list<int>> lists_std(LIST_COUNT);
+
+        for (size_t iter = 0; iter < ITER_COUNT; ++iter) {
+            for (size_t list = 0; list < LIST_COUNT; ++list) {
+                size_t case_type = lists_task[list].empty() ? 0 : RandomUInt(3);
+                switch (case_type) {
+                    case 0 : {
+                        // Random Push
+                        auto val = RandomUInt();
+                        if (TossCoin()) {
+                            lists_task[list].push_back(val);
+                            lists_std[list].push_back(val);
+                        } else {
+                            lists_task[list].push_front(val);
+                            lists_std[list].push_front(val);
+                        }
+                        break;
+                    }
+                    case 1: {
+                        // Random Pop
+                        if (TossCoin()) {
+                            lists_task[list].pop_back();
+                            lists_std[list].pop_back();
+                        } else {
+                            lists_task[list].pop_front();
+                            lists_std[list].pop_front();
+                        }
+                        break;
+                    }
+                    case 2: {
+                        lists_task[list].remove(lists_task[list].back());
+                        lists_std[list].remove(lists_std[list].back());
+                        break;
+                    }
+                    case 3: {
+                        lists_task[list].sort();
+                        lists_std[list].sort();
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (size_t list = 0; list < LIST_COUNT; ++list) {
+            ASSERT_EQUAL_MSG(lists_task[list], lists_std[list], "unrolled_list mixed operations")
+        }
+    }
+
     {
         const size_t LIST_COUNT = 5;
         const size_t ITER_COUNT = 30000;
@@ -0,0 +1,248 @@
+#include "unrolled_list.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+
+namespace task {
+
+
+unrolled_list::unrolled_list() {
+    reset();
+}
+
+unrolled_list::unrolled_list(size_t count, const int& value) : unrolled_list() {
+    for (size_t i = 0; i < count; ++i) {
+        push_back(value);
+    }
+}
+
+unrolled_list::unrolled_list(const unrolled_list& other) : unrolled_list() {
+    for (int value : other) {
+        push_back(value);
+    }
+}
+
+unrolled_list::~unrolled_list() {
+    clear();
+}
+
+unrolled_list& unrolled_list::operator=(const unrolled_list& other) {
+    if (this != &other) {
+        unrolled_list copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+
+int& unrolled_list::front() {
+    return as_node(head_.next)->values[head_.next->first];
+}
+
+const int& unrolled_list::front() const {
+    return as_node(head_.next)->values[head_.next->first];
+}
+
+int& unrolled_list::back() {
+    return as_node(head_.prev)->values[head_.prev->last - 1];
+}
+
+const int& unrolled_list::back() const {
+    return as_node(head_.prev)->values[head_.prev->last - 1];
+}
+
+
+unrolled_list::iterator unrolled_list::begin() {
+    return iterator(head_.next, head_.next->first);
+}
+
+unrolled_list::const_iterator unrolled_list::begin() const {
+    return const_iterator(head_.next, head_.next->first);
+}
+
+unrolled_list::iterator unrolled_list::end() {
+    return iterator(&head_, 0);
+}
+
+unrolled_list::const_iterator unrolled_list::end() const {
+    return const_iterator(&head_, 0);
+}
+
+
+bool unrolled_list::empty() const {
+    return size_ == 0;
+}
+
+size_t unrolled_list::size() const {
+    return size_;
+}
+
+void unrolled_list::clear() {
+    node_base* n = head_.next;
+    while (n != &head_) {
+        node_base* next = n->next;
+        delete as_node(n);
+        n = next;
+    }
+    reset();
+}
+
+
+// A full tail gets a fresh node that fills from slot 0 upwards.
+void unrolled_list::push_back(const int& value) {
+    node_base* tail = head_.prev;
+    if (tail == &head_ || tail->last == kNodeCapacity) {
+        tail = link_new_node(&head_, 0);
+    }
+    as_node(tail)->values[tail->last++] = value;
+    ++size_;
+}
+
+void unrolled_list::pop_back() {
+    node_base* tail = head_.prev;
+    if (--tail->last == tail->first) {
+        unlink_node(tail);
+    }
+    --size_;
+}
+
+// A full head gets a fresh node that fills from the last slot downwards, so repeated
+// push_front never shifts values.
+void unrolled_list::push_front(const int& value) {
+    node_base* front = head_.next;
+    if (front == &head_ || front->first == 0) {
+        front = link_new_node(head_.next, kNodeCapacity);
+    }
+    as_node(front)->values[--front->first] = value;
+    ++size_;
+}
+
+void unrolled_list::pop_front() {
+    node_base* front = head_.next;
+    if (++front->first == front->last) {
+        unlink_node(front);
+    }
+    --size_;
+}
+
+void unrolled_list::resize(size_t count) {
+    while (size_ > count) {
+        pop_back();
+    }
+    while (size_ < count) {
+        push_back(int());
+    }
+}
+
+void unrolled_list::swap(unrolled_list& other) {
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    for (unrolled_list* l : {this, &other}) {
+        if (l->size_ == 0) {
+            l->reset();
+        } else {
+            l->head_.next->prev = &l->head_;
+            l->head_.prev->next = &l->head_;
+        }
+    }
+}
+
+
+void unrolled_list::remove(const int& value) {
+    const int copy = value;
+    compact([copy](int current, const int*) { return current != copy; });
+}
+
+void unrolled_list::unique() {
+    compact([](int current, const int* kept) { return kept == nullptr || current != *kept; });
+}
+
+// Values are sorted in place inside the existing nodes; only a flat copy of the ints is made.
+void unrolled_list::sort() {
+    std::vector<int> values(begin(), end());
+    std::sort(values.begin(), values.end());
+    std::copy(values.begin(), values.end(), begin());
+}
+
+
+unrolled_list::node* unrolled_list::as_node(node_base* n) {
+    return static_cast<node*>(n);
+}
+
+const unrolled_list::node* unrolled_list::as_node(const node_base* n) {
+    return static_cast<const node*>(n);
+}
+
+// Links an empty node before `pos` whose [first, last) starts out as [index, index).
+unrolled_list::node* unrolled_list::link_new_node(node_base* pos, uint16_t index) {
+    node* n = new node;
+    n->first = index;
+    n->last = index;
+    n->next = pos;
+    n->prev = pos->prev;
+    pos->prev->next = n;
+    pos->prev = n;
+    return n;
+}
+
+void unrolled_list::unlink_node(node_base* n) {
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    delete as_node(n);
+}
+
+// Streams every value through `keep(value, last_kept_or_null)` and packs the survivors into
+// full nodes from the front; nodes left empty are freed. The writer never overtakes the reader,
+// so this runs in place in one pass.
+template <typename Keep>
+void unrolled_list::compact(Keep keep) {
+    if (size_ == 0) {
+        return;
+    }
+    node_base* writer = head_.next;
+    uint16_t write_index = writer->first;
+    const int* kept = nullptr;
+    size_t kept_count = 0;
+
+    for (node_base* reader = head_.next; reader != &head_; reader = reader->next) {
+        for (uint16_t i = reader->first; i < reader->last; ++i) {
+            int current = as_node(reader)->values[i];
+            if (!keep(current, kept)) {
+                continue;
+            }
+            if (write_index == kNodeCapacity) {
+                writer->last = write_index;
+                writer = writer->next;
+                writer->first = 0;
+                write_index = 0;
+            }
+            as_node(writer)->values[write_index] = current;
+            kept = &as_node(writer)->values[write_index];
+            ++write_index;
+            ++kept_count;
+        }
+    }
+
+    if (kept_count == 0) {
+        clear();
+        return;
+    }
+    writer->last = write_index;
+    while (writer->next != &head_) {
+        unlink_node(writer->next);
+    }
+    size_ = kept_count;
+}
+
+void unrolled_list::reset() {
+    head_.prev = &head_;
+    head_.next = &head_;
+    head_.first = 0;
+    head_.last = 0;
+    size_ = 0;
+}
+
+}  // namespace task
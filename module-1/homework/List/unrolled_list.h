@@ -0,0 +1,162 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+
+namespace task {
+
+
+// Same interface as task::list, but every node stores up to kNodeCapacity values in a small
+// array, so a scan takes one pointer hop per node instead of one per element. A node is sized
+// to two cache lines.
+class unrolled_list {
+
+    struct node_base {
+        node_base* prev;
+        node_base* next;
+        // values live in [first, last) of the node's array
+        uint16_t first;
+        uint16_t last;
+    };
+
+    struct node;
+
+public:
+
+    static constexpr size_t kNodeBytes = 128;
+    static constexpr size_t kNodeCapacity = (kNodeBytes - sizeof(node_base)) / sizeof(int);
+
+    template <bool IsConst>
+    class basic_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<IsConst, const int*, int*>::type;
+        using reference = typename std::conditional<IsConst, const int&, int&>::type;
+
+        basic_iterator() = default;
+
+        template <bool WasConst, typename = typename std::enable_if<IsConst && !WasConst>::type>
+        basic_iterator(const basic_iterator<WasConst>& other)  // NOLINT
+            : node_(other.node_), index_(other.index_) {
+        }
+
+        reference operator*() const {
+            return static_cast<node_ptr>(node_)->values[index_];
+        }
+        pointer operator->() const {
+            return &**this;
+        }
+
+        basic_iterator& operator++() {
+            if (++index_ == node_->last) {
+                node_ = node_->next;
+                index_ = node_->first;
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+        basic_iterator& operator--() {
+            if (index_ == node_->first) {
+                node_ = node_->prev;
+                index_ = node_->last;
+            }
+            --index_;
+            return *this;
+        }
+        basic_iterator operator--(int) {
+            basic_iterator copy(*this);
+            --*this;
+            return copy;
+        }
+
+        friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) {
+            return lhs.node_ == rhs.node_ && lhs.index_ == rhs.index_;
+        }
+        friend bool operator!=(const basic_iterator& lhs, const basic_iterator& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        friend class unrolled_list;
+
+        using base_ptr = typename std::conditional<IsConst, const node_base*, node_base*>::type;
+        using node_ptr = typename std::conditional<IsConst, const node*, node*>::type;
+
+        basic_iterator(base_ptr n, size_t index) : node_(n), index_(index) {
+        }
+
+        base_ptr node_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    unrolled_list();
+    unrolled_list(size_t count, const int& value = int());
+    unrolled_list(const unrolled_list& other);
+
+    ~unrolled_list();
+    unrolled_list& operator=(const unrolled_list& other);
+
+
+    int& front();
+    const int& front() const;
+
+    int& back();
+    const int& back() const;
+
+
+    iterator begin();
+    const_iterator begin() const;
+
+    iterator end();
+    const_iterator end() const;
+
+
+    bool empty() const;
+    size_t size() const;
+    void clear();
+
+
+    void push_back(const int& value);
+    void pop_back();
+    void push_front(const int& value);
+    void pop_front();
+    void resize(size_t count);
+    void swap(unrolled_list& other);
+
+
+    void remove(const int& value);
+    void unique();
+    void sort();
+
+private:
+
+    struct node : node_base {
+        int values[kNodeCapacity];
+    };
+
+    static node* as_node(node_base* n);
+    static const node* as_node(const node_base* n);
+
+    node* link_new_node(node_base* pos, uint16_t index);
+    void unlink_node(node_base* n);
+    template <typename Keep>
+    void compact(Keep keep);
+    void reset();
+
+    node_base head_;
+    size_t size_;
+
+};
+
+}  // namespace task
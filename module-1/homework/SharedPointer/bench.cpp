@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../Allocator/src/allocator/allocator.h"
+#include "src/shared_ptr/atomic_shared_ptr.h"
+#include "src/shared_ptr/intrusive_ptr.h"
+#include "src/shared_ptr/reclaimer.h"
+#include "src/shared_ptr/shared_ptr.h"
+
+// Timings of SharedPtr built by MakeShared and AllocateShared against SharedPtr(new T), of the
+// atomic counts against LocalSharedPtr's plain ones, of atomic against biased counts on 1 to 4
+// threads, of loading a published pointer through AtomicSharedPtr or a mutex, of counters
+// sharing a line with the object against PaddedCounting, of converting to IntrusivePtr, of
+// WeakPtr::Lock and Expired, and the latency of dropping pointers with and without DeferredDelete.
+// Usage: bench [max_size]  (sizes run from 10^3 up to max_size, 10^6 by default)
+//
+// ns/op is per pointer. allocs/op counts calls into the global operator new.
+
+namespace {
+
+std::atomic<uint64_t> global_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+volatile uint64_t sink;
+
+struct Small {
+    explicit Small(uint64_t i) : value(i) {
+    }
+    uint64_t value;
+};
+
+// A whole cache line of payload, read in full on every access.
+struct Line {
+    explicit Line(uint64_t i) {
+        std::fill(std::begin(values), std::end(values), i);
+    }
+    uint64_t values[8];
+};
+
+// The same payload with the count inside it, for IntrusivePtr.
+template <typename Payload, typename Policy>
+struct Intrusive : Payload, RefCounted<Intrusive<Payload, Policy>, Policy> {
+    explicit Intrusive(uint64_t i) : Payload(i) {
+    }
+};
+
+uint64_t Touch(const Small& value) {
+    return value.value;
+}
+
+uint64_t Touch(const Line& value) {
+    uint64_t sum = 0;
+    for (uint64_t v : value.values) {
+        sum += v;
+    }
+    return sum;
+}
+
+struct Result {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// Runs `body` once after `setup`; `body` returns how many operations it performed.
+Result Measure(const std::function<void()>& setup, const std::function<uint64_t()>& body) {
+    setup();
+    uint64_t allocations = global_allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ops = body();
+    auto finish = std::chrono::steady_clock::now();
+    allocations = global_allocations.load(std::memory_order_relaxed) - allocations;
+    ops = std::max<uint64_t>(ops, 1);
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+    return {ns / static_cast<double>(ops),
+            static_cast<double>(allocations) / static_cast<double>(ops)};
+}
+
+void Report(const char* op, const char* maker, const char* payload, std::size_t n,
+            Result result) {
+    std::printf("%-10s %-20s %-8s %9zu %10.2f %10.4f\n", op, maker, payload, n, result.ns_per_op,
+                result.allocs_per_op);
+}
+
+// Create: n pointers. Access: copy a pointer and read its object, visiting the pointers in random
+// order so that every visit misses the cache. Destroy: drop them all.
+template <typename Pointer>
+void RunSuite(const char* maker, const char* payload, std::size_t n,
+              const std::function<Pointer(uint64_t)>& make) {
+    std::vector<Pointer> pointers;
+    pointers.reserve(n);
+    Report("Create", maker, payload, n, Measure([] {}, [&] {
+               for (std::size_t i = 0; i < n; ++i) {
+                   pointers.push_back(make(i));
+               }
+               return n;
+           }));
+
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(n));
+    Report("Access", maker, payload, n, Measure([] {}, [&] {
+               uint64_t sum = 0;
+               for (std::size_t i : order) {
+                   Pointer copy = pointers[i];
+                   sum += Touch(*copy);
+               }
+               sink = sum;
+               return n;
+           }));
+
+    Report("Destroy", maker, payload, n, Measure([] {}, [&] {
+               pointers.clear();
+               return n;
+           }));
+}
+
+// Copy: n copies of one pointer, so only the count changes. Release: drop them again.
+template <typename Pointer>
+void RunCopies(const char* maker, const char* payload, std::size_t n, const Pointer& source) {
+    std::vector<Pointer> copies;
+    copies.reserve(n);
+    Report("Copy", maker, payload, n, Measure([] {}, [&] {
+               for (std::size_t i = 0; i < n; ++i) {
+                   copies.push_back(source);
+               }
+               return n;
+           }));
+    Report("Release", maker, payload, n, Measure([] {}, [&] {
+               copies.clear();
+               return n;
+           }));
+}
+
+template <typename T>
+void RunPayload(const char* payload, std::size_t n) {
+    RunSuite<SharedPtr<T>>("MakeShared", payload, n, [](uint64_t i) { return MakeShared<T>(i); });
+    RunSuite<SharedPtr<T>>("SharedPtr(new T)", payload, n,
+                           [](uint64_t i) { return SharedPtr<T>(new T(i)); });
+    CustomAllocator<T> alloc;
+    RunSuite<SharedPtr<T>>("AllocateShared/Pool", payload, n,
+                           [&alloc](uint64_t i) { return AllocateShared<T>(alloc, i); });
+    RunSuite<LocalSharedPtr<T>>("MakeLocalShared", payload, n,
+                                [](uint64_t i) { return MakeLocalShared<T>(i); });
+    using AtomicIntrusive = Intrusive<T, AtomicCounting>;
+    using LocalIntrusive = Intrusive<T, LocalCounting>;
+    RunSuite<IntrusivePtr<AtomicIntrusive>>(
+        "MakeIntrusive", payload, n, [](uint64_t i) { return MakeIntrusive<AtomicIntrusive>(i); });
+    RunSuite<IntrusivePtr<LocalIntrusive>>("MakeIntrusive/Local", payload, n, [](uint64_t i) {
+        return MakeIntrusive<LocalIntrusive>(i);
+    });
+    RunCopies("SharedPtr", payload, n, MakeShared<T>(0));
+    RunCopies("LocalSharedPtr", payload, n, MakeLocalShared<T>(0));
+    RunCopies("IntrusivePtr", payload, n, MakeIntrusive<AtomicIntrusive>(0));
+    RunCopies("IntrusivePtr/Local", payload, n, MakeIntrusive<LocalIntrusive>(0));
+}
+
+// Copy and release pairs, in batches of 16 live copies, on `threads` threads at once; n is per
+// thread. OwnCopy: each thread copies a pointer it made. SharedCopy: all copy one made by main.
+template <typename Policy>
+void RunScaling(const char* maker, std::size_t threads, std::size_t n) {
+    char payload[16];
+    std::snprintf(payload, sizeof(payload), "8B/%zut", threads);
+    auto run = [&](const std::function<SharedPtr<Small, Policy>()>& source) {
+        return Measure([] {}, [&] {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&] {
+                    SharedPtr<Small, Policy> pointer = source();
+                    std::vector<SharedPtr<Small, Policy>> copies;
+                    copies.reserve(16);
+                    for (std::size_t i = 0; i < n; ++i) {
+                        copies.push_back(pointer);
+                        if (copies.size() == 16) {
+                            copies.clear();
+                        }
+                    }
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+            return n * threads;
+        });
+    };
+    Report("OwnCopy", maker, payload, n, run([] { return MakeShared<Small, Policy>(0); }));
+    SharedPtr<Small, Policy> shared = MakeShared<Small, Policy>(0);
+    Report("SharedCopy", maker, payload, n, run([&shared] { return shared; }));
+}
+
+// An object that its threads keep writing to.
+struct Hot {
+    explicit Hot(uint64_t i) : value(i) {
+    }
+    std::atomic<uint64_t> value;
+};
+
+// Half the threads copy and release one pointer, in batches of 16 live copies, while the other
+// half increment the object it points to; n operations per thread.
+template <typename Policy>
+void RunFalseSharing(const char* maker, std::size_t threads, std::size_t n) {
+    char payload[16];
+    std::snprintf(payload, sizeof(payload), "8B/%zut", threads);
+    SharedPtr<Hot, Policy> shared = MakeShared<Hot, Policy>(0);
+    Report("CopyWrite", maker, payload, n, Measure([] {}, [&] {
+               std::vector<std::thread> workers;
+               for (std::size_t t = 0; t < threads; ++t) {
+                   workers.emplace_back([&shared, n, writer = t % 2 == 1] {
+                       if (writer) {
+                           for (std::size_t i = 0; i < n; ++i) {
+                               shared->value.fetch_add(1, std::memory_order_relaxed);
+                           }
+                           return;
+                       }
+                       std::vector<SharedPtr<Hot, Policy>> copies;
+                       copies.reserve(16);
+                       for (std::size_t i = 0; i < n; ++i) {
+                           copies.push_back(shared);
+                           if (copies.size() == 16) {
+                               copies.clear();
+                           }
+                       }
+                   });
+               }
+               for (std::thread& worker : workers) {
+                   worker.join();
+               }
+               return n * threads;
+           }));
+}
+
+// What AtomicSharedPtr replaces: a SharedPtr behind a mutex.
+template <typename T>
+class LockedSharedPtr {
+public:
+    explicit LockedSharedPtr(SharedPtr<T> value) : value_(std::move(value)) {
+    }
+
+    SharedPtr<T> Load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return value_;
+    }
+
+    // The old value ends up in `desired` and is released outside the lock.
+    void Store(SharedPtr<T> desired) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        value_.Swap(desired);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    SharedPtr<T> value_;
+};
+
+// `readers` threads each load and read the published pointer n times while a writer publishes a
+// new one every 50us.
+template <typename Holder>
+void RunPublish(const char* maker, std::size_t readers, std::size_t n) {
+    char payload[16];
+    std::snprintf(payload, sizeof(payload), "8B/%zur", readers);
+    Holder holder(MakeShared<Small>(0));
+    std::atomic<bool> done{false};
+    Report("Load", maker, payload, n, Measure([] {}, [&] {
+               std::thread writer([&] {
+                   for (uint64_t i = 1; !done.load(std::memory_order_relaxed); ++i) {
+                       holder.Store(MakeShared<Small>(i));
+                       std::this_thread::sleep_for(std::chrono::microseconds(50));
+                   }
+               });
+               std::vector<std::thread> workers;
+               for (std::size_t t = 0; t < readers; ++t) {
+                   workers.emplace_back([&] {
+                       uint64_t sum = 0;
+                       for (std::size_t i = 0; i < n; ++i) {
+                           sum += Touch(*holder.Load());
+                       }
+                       sink = sum;
+                   });
+               }
+               for (std::thread& worker : workers) {
+                   worker.join();
+               }
+               done.store(true, std::memory_order_relaxed);
+               writer.join();
+               return n * readers;
+           }));
+}
+
+// `threads` threads share one WeakPtr to a live object and each run n of: Lock and read the
+// object (the CAS loop), Expired (a relaxed load), or, for reference, copy the SharedPtr itself.
+void RunWeak(std::size_t threads, std::size_t n) {
+    char payload[16];
+    std::snprintf(payload, sizeof(payload), "8B/%zut", threads);
+    SharedPtr<Small> shared = MakeShared<Small>(1);
+    WeakPtr<Small> weak(shared);
+    auto run = [&](const std::function<uint64_t()>& op) {
+        return Measure([] {}, [&] {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&] {
+                    uint64_t sum = 0;
+                    for (std::size_t i = 0; i < n; ++i) {
+                        sum += op();
+                    }
+                    sink = sum;
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+            return n * threads;
+        });
+    };
+    Report("Lock", "WeakPtr", payload, n, run([&weak] { return weak.Lock()->value; }));
+    Report("Expired", "WeakPtr", payload, n,
+           run([&weak] { return static_cast<uint64_t>(weak.Expired()); }));
+    Report("Copy", "SharedPtr", payload, n,
+           run([&shared] { return SharedPtr<Small>(shared)->value; }));
+}
+
+struct GraphNode {
+    explicit GraphNode(uint64_t i) : payload(i) {
+    }
+    std::vector<SharedPtr<GraphNode>> children;
+    uint64_t payload;
+};
+
+// A tree of `nodes` nodes, four children each. Only the root goes through `make_root`.
+SharedPtr<GraphNode> BuildGraph(std::size_t nodes,
+                                const std::function<SharedPtr<GraphNode>()>& make_root) {
+    SharedPtr<GraphNode> root = make_root();
+    std::vector<GraphNode*> frontier{root.Get()};
+    for (std::size_t built = 1, next = 0; built < nodes; ++next) {
+        for (int c = 0; c < 4 && built < nodes; ++c, ++built) {
+            frontier[next]->children.push_back(MakeShared<GraphNode>(built));
+            frontier.push_back(frontier[next]->children.back().Get());
+        }
+    }
+    return root;
+}
+
+// Times each of `drops` Resets of the last pointer to a graph: one node, except every 100th,
+// which drops a tree of `big` nodes. The graphs are built beforehand.
+void RunTail(const char* maker, std::size_t drops, std::size_t big,
+             const std::function<SharedPtr<GraphNode>()>& make_root) {
+    std::vector<SharedPtr<GraphNode>> graphs;
+    graphs.reserve(drops);
+    for (std::size_t i = 0; i < drops; ++i) {
+        graphs.push_back(BuildGraph(i % 100 == 99 ? big : 1, make_root));
+    }
+    std::vector<double> latencies;
+    latencies.reserve(drops);
+    for (SharedPtr<GraphNode>& graph : graphs) {
+        auto start = std::chrono::steady_clock::now();
+        graph.Reset();
+        auto finish = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(finish - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    std::printf("%-10s %-20s %9zu %10.0f %10.0f %10.0f %10.0f\n", "Drop", maker, drops,
+                percentile(0.5), percentile(0.99), percentile(0.999), latencies.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    std::printf("%-10s %-20s %-8s %9s %10s %10s\n", "op", "maker", "payload", "n", "ns/op",
+                "allocs/op");
+    for (std::size_t n = 1000; n <= max_size; n *= 10) {
+        RunPayload<Small>("8B", n);
+        RunPayload<Line>("64B", n);
+    }
+    for (std::size_t threads = 1; threads <= 4; threads *= 2) {
+        RunScaling<AtomicCounting>("SharedPtr", threads, max_size);
+        RunScaling<BiasedCounting>("Biased", threads, max_size);
+    }
+    for (std::size_t readers = 1; readers <= 4; readers *= 2) {
+        RunPublish<LockedSharedPtr<Small>>("Mutex+SharedPtr", readers, max_size);
+        RunPublish<AtomicSharedPtr<Small>>("AtomicSharedPtr", readers, max_size);
+    }
+    std::printf("MakeShared block bytes: %zu default, %zu PaddedCounting\n",
+                sizeof(InplaceControlBlock<Hot>), sizeof(InplaceControlBlock<Hot, PaddedCounting>));
+    for (std::size_t threads = 2; threads <= 4; threads *= 2) {
+        RunFalseSharing<AtomicCounting>("SharedPtr", threads, max_size);
+        RunFalseSharing<PaddedCounting>("PaddedCounting", threads, max_size);
+    }
+    for (std::size_t threads = 1; threads <= 4; threads *= 2) {
+        RunWeak(threads, max_size);
+    }
+
+    std::printf("%-10s %-20s %9s %10s %10s %10s %10s\n", "op", "maker", "drops", "p50 ns",
+                "p99 ns", "p99.9 ns", "max ns");
+    std::size_t big = std::min<std::size_t>(max_size / 100, 100'000);
+    RunTail("Inline", 2000, big, [] { return MakeShared<GraphNode>(0); });
+    {
+        Reclaimer reclaimer(std::chrono::milliseconds(1));
+        RunTail("DeferredDelete", 2000, big, [&reclaimer] {
+            return SharedPtr<GraphNode>(new GraphNode(0), DeferredDelete(reclaimer));
+        });
+    }
+    return 0;
+}
@@ -1,28 +1,530 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
+// Counting policies. AtomicCounting lets the owners of one object live on different threads;
+// LocalCounting uses plain integers and is for pointers that never leave the thread that made
+// them, where every copy and destruction is then an ordinary increment or decrement.
+struct AtomicCounting {
+    using Counter = std::atomic<std::size_t>;
+
+    static std::size_t Load(const Counter& count) noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    // A new reference can only be made from an existing one, which keeps the count above zero, so
+    // the increment needs no ordering.
+    static void Increment(Counter& count) noexcept {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns whether the count reached zero. acq_rel makes every owner's writes to the object
+    // visible to whichever thread destroys it.
+    static bool Decrement(Counter& count) noexcept {
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    // A CAS loop rather than fetch_add, which could revive a count that already reached zero.
+    // Acquire on success pairs with the acq_rel releases, so the new owner sees every write that
+    // earlier owners made to the object; a failed attempt reads nothing and stays relaxed.
+    static bool IncrementIfNonZero(Counter& count) noexcept {
+        std::size_t current = count.load(std::memory_order_relaxed);
+        while (current != 0) {
+            if (count.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+struct LocalCounting {
+    using Counter = std::size_t;
+
+    static std::size_t Load(const Counter& count) noexcept {
+        return count;
+    }
+    static void Increment(Counter& count) noexcept {
+        ++count;
+    }
+    static bool Decrement(Counter& count) noexcept {
+        return --count == 0;
+    }
+    static bool IncrementIfNonZero(Counter& count) noexcept {
+        if (count == 0) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+};
+
+// AtomicCounting with each counter on a cache line of its own. Copies and releases on one thread
+// then no longer invalidate the line that other threads read the object (or the deleter) from,
+// nor do WeakPtr operations contend with SharedPtr ones. The price is memory: a block grows from
+// a few words to four lines (the vtable pointer keeps one to itself), 256 bytes for a
+// MakeShared'd int instead of 32.
+struct PaddedCounting {
+    struct alignas(64) Counter {
+        std::atomic<std::size_t> value;
+    };
+
+    static std::size_t Load(const Counter& count) noexcept {
+        return AtomicCounting::Load(count.value);
+    }
+    static void Increment(Counter& count) noexcept {
+        AtomicCounting::Increment(count.value);
+    }
+    static bool Decrement(Counter& count) noexcept {
+        return AtomicCounting::Decrement(count.value);
+    }
+    static bool IncrementIfNonZero(Counter& count) noexcept {
+        return AtomicCounting::IncrementIfNonZero(count.value);
+    }
+};
+
+// Strong reference count, shared by every SharedPtr to one object.
+template <typename Policy = AtomicCounting>
 class SharedCount {
 public:
-    // Your code goes here...
+    SharedCount() = default;
+    SharedCount(const SharedCount&) = delete;
+    SharedCount& operator=(const SharedCount&) = delete;
+
+    std::size_t UseCount() const noexcept {
+        return Policy::Load(shared_count_);
+    }
+
+    void AddShared() noexcept {
+        Policy::Increment(shared_count_);
+    }
 
 protected:
-    // Your code goes here...
+    virtual ~SharedCount() = default;
+
+    bool AddSharedIfNonZero() noexcept {
+        return Policy::IncrementIfNonZero(shared_count_);
+    }
+
+    // Returns whether that was the last strong reference.
+    bool DropShared() noexcept {
+        return Policy::Decrement(shared_count_);
+    }
+
+    virtual void ReleaseLastShared() noexcept = 0;
+
+private:
+    typename Policy::Counter shared_count_{1};
 };
 
-class SharedWeakCount : public SharedCount {
+// Biased reference counting (Choi, Shull, Torrellas, PACT 2018). Each block is biased towards the
+// thread that created it: that thread counts its copies and releases in a counter only it writes,
+// with plain loads and stores, and every other thread uses an atomic counter. The two are merged
+// when the owner's counter drops to zero, after which the block behaves like AtomicCounting.
+//
+// Until then the atomic counter can go negative, so another thread cannot tell whether it dropped
+// the last reference. The first time it would take the counter below zero it hands its reference
+// to the owner instead, through a queue in the owner's record; the owner merges such blocks when it
+// next creates one, on BiasedCounting::Drain, or when the thread exits. The object may therefore
+// outlive its last reference by that long. Weak counts are atomic as usual.
+//
+// Ownership belongs to a per-thread record rather than to the thread: the record of a thread that
+// has exited can be taken over by a new thread, or claimed for a moment by whoever queues a block
+// on it, so the queue is always drained by someone.
+struct BiasedCounting : AtomicCounting {
+    struct Owner;
+
+    // Merges the blocks other threads have queued for the calling thread.
+    static void Drain() noexcept;
+
+private:
+    friend class SharedCount<BiasedCounting>;
+
+    class ThreadExit;
+
+    // The calling thread's record, attached on first use; drains it on the way.
+    static Owner* Adopt();
+
+    static Owner* Current() noexcept {
+        return current;
+    }
+    static Owner* Attach();
+    static void Detach() noexcept;
+
+    static inline thread_local Owner* current = nullptr;
+    static inline std::atomic<Owner*> owners{nullptr};
+};
+
+template <>
+class SharedCount<BiasedCounting> {
 public:
-    // Your code goes here...
+    SharedCount() : owner_(BiasedCounting::Adopt()) {
+    }
+    SharedCount(const SharedCount&) = delete;
+    SharedCount& operator=(const SharedCount&) = delete;
+
+    // Exact on the owner thread, a snapshot elsewhere.
+    std::size_t UseCount() const noexcept {
+        std::int64_t shared = shared_.load(std::memory_order_relaxed);
+        std::int64_t queued = (shared & kQueued) != 0 ? 1 : 0;
+        return static_cast<std::size_t>(static_cast<std::int64_t>(Biased()) + Count(shared) -
+                                        queued);
+    }
+
+    void AddShared() noexcept {
+        if (IsBiased()) {
+            biased_.store(Biased() + 1, std::memory_order_relaxed);
+        } else {
+            shared_.fetch_add(kOne, std::memory_order_relaxed);
+        }
+    }
 
 protected:
-    // Your code goes here...
+    virtual ~SharedCount() = default;
+
+    // While the block is unmerged its object is alive whatever the counters say, since only the
+    // owner's record can destroy it.
+    bool AddSharedIfNonZero() noexcept {
+        if (IsBiased()) {
+            biased_.store(Biased() + 1, std::memory_order_relaxed);
+            return true;
+        }
+        std::int64_t shared = shared_.load(std::memory_order_relaxed);
+        do {
+            if ((shared & kMerged) != 0 && Count(shared) == 0) {
+                return false;
+            }
+        } while (!shared_.compare_exchange_weak(shared, shared + kOne, std::memory_order_acquire,
+                                                std::memory_order_relaxed));
+        return true;
+    }
+
+    bool DropShared() noexcept {
+        if (IsBiased()) {
+            std::size_t biased = Biased() - 1;
+            biased_.store(biased, std::memory_order_relaxed);
+            return biased == 0 && Merge(0);
+        }
+        std::int64_t shared = shared_.load(std::memory_order_relaxed);
+        if ((shared & kMerged) != 0) {
+            return Count(shared_.fetch_sub(kOne, std::memory_order_acq_rel)) == 1;
+        }
+        for (;;) {
+            bool hand_over = (shared & (kMerged | kQueued)) == 0 && Count(shared) <= 0;
+            std::int64_t next = hand_over ? shared | kQueued : shared - kOne;
+            if (shared_.compare_exchange_weak(shared, next, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+                if (hand_over) {
+                    Enqueue();
+                    return false;
+                }
+                return (shared & kMerged) != 0 && Count(next) == 0;
+            }
+        }
+    }
+
+    virtual void ReleaseLastShared() noexcept = 0;
+
+private:
+    friend struct BiasedCounting;
+
+    // The atomic counter holds the count above two flag bits.
+    static constexpr std::int64_t kMerged = 1;
+    static constexpr std::int64_t kQueued = 2;
+    static constexpr std::int64_t kOne = 4;
+
+    static std::int64_t Count(std::int64_t shared) noexcept {
+        return (shared - (shared & (kOne - 1))) / kOne;
+    }
+
+    std::size_t Biased() const noexcept {
+        return biased_.load(std::memory_order_relaxed);
+    }
+
+    // The biased counter is zero exactly once the block is merged.
+    bool IsBiased() const noexcept {
+        return owner_ == BiasedCounting::Current() && Biased() != 0;
+    }
+
+    // Run by the holder of the owner's record: folds `biased_` into the atomic counter, together
+    // with `delta`, and returns whether that leaves no references.
+    bool Merge(std::int64_t delta) noexcept {
+        std::size_t biased = Biased();
+        if (biased != 0) {
+            biased_.store(0, std::memory_order_relaxed);
+        }
+        delta += static_cast<std::int64_t>(biased) * kOne;
+        if ((shared_.load(std::memory_order_relaxed) & kMerged) == 0) {
+            delta += kMerged;
+        }
+        std::int64_t shared = shared_.fetch_add(delta, std::memory_order_acq_rel) + delta;
+        return Count(shared) == 0;
+    }
+
+    // A queued block carries the reference that was handed over, which keeps it alive.
+    void Settle() noexcept {
+        if (Merge(-kOne - kQueued)) {
+            ReleaseLastShared();
+        }
+    }
+
+    void Enqueue() noexcept;
+
+    BiasedCounting::Owner* const owner_;
+    std::atomic<std::size_t> biased_{1};
+    std::atomic<std::int64_t> shared_{0};
+    SharedCount* queue_next_ = nullptr;
 };
 
-template <typename T, typename Deleter>
-class ControlBlock : public SharedWeakCount {
+// On a cache line of its own so that queueing on one record does not disturb its neighbours'
+// owners. `new Owner` honours the alignment.
+struct alignas(64) BiasedCounting::Owner {
+    std::atomic<SharedCount<BiasedCounting>*> queue{nullptr};
+    std::atomic<bool> active{true};
+    Owner* next = nullptr;
+
+    bool TryClaim() noexcept {
+        return !active.load(std::memory_order_relaxed) &&
+               !active.exchange(true, std::memory_order_acquire);
+    }
+
+    // Caller holds the record. Settling can run destructors that queue more blocks here.
+    void Drain() noexcept {
+        SharedCount<BiasedCounting>* block;
+        while ((block = queue.exchange(nullptr, std::memory_order_acquire)) != nullptr) {
+            while (block != nullptr) {
+                SharedCount<BiasedCounting>* next_block = block->queue_next_;
+                block->Settle();
+                block = next_block;
+            }
+        }
+    }
+
+    // Drains the record on behalf of a thread that has let it go, for as long as blocks keep
+    // arriving and nobody else has claimed it. Both sides publish (the queue or the release)
+    // before they look at the other's, so one of them always sees the last block.
+    void HelpDrain() noexcept {
+        while (queue.load(std::memory_order_seq_cst) != nullptr && TryClaim()) {
+            Drain();
+            active.store(false, std::memory_order_seq_cst);
+        }
+    }
+};
+
+class BiasedCounting::ThreadExit {
+public:
+    ThreadExit() = default;
+    ThreadExit(const ThreadExit&) = delete;
+    ThreadExit& operator=(const ThreadExit&) = delete;
+    ~ThreadExit() {
+        BiasedCounting::Detach();
+    }
+};
+
+inline void SharedCount<BiasedCounting>::Enqueue() noexcept {
+    // Once the CAS succeeds the owner may settle and free this block at any moment, so the record
+    // is read into a local first; records are never freed, so the local stays valid.
+    BiasedCounting::Owner* owner = owner_;
+    queue_next_ = owner->queue.load(std::memory_order_relaxed);
+    while (!owner->queue.compare_exchange_weak(queue_next_, this, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed)) {
+    }
+    if (!owner->active.load(std::memory_order_seq_cst)) {
+        owner->HelpDrain();
+    }
+}
+
+inline void BiasedCounting::Drain() noexcept {
+    if (current != nullptr) {
+        current->Drain();
+    }
+}
+
+inline BiasedCounting::Owner* BiasedCounting::Adopt() {
+    if (current == nullptr) {
+        return Attach();
+    }
+    if (current->queue.load(std::memory_order_relaxed) != nullptr) {
+        current->Drain();
+    }
+    return current;
+}
+
+// Takes over a record left by an exited thread, or adds one; records are never freed.
+inline BiasedCounting::Owner* BiasedCounting::Attach() {
+    static thread_local ThreadExit thread_exit;
+    Owner* head = owners.load(std::memory_order_acquire);
+    Owner* owner = head;
+    while (owner != nullptr && !owner->TryClaim()) {
+        owner = owner->next;
+    }
+    if (owner == nullptr) {
+        owner = new Owner;
+        owner->next = head;
+        while (!owners.compare_exchange_weak(owner->next, owner, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+        }
+    }
+    current = owner;
+    owner->Drain();
+    return owner;
+}
+
+inline void BiasedCounting::Detach() noexcept {
+    Owner* owner = current;
+    if (owner == nullptr) {
+        return;
+    }
+    owner->Drain();
+    current = nullptr;
+    owner->active.store(false, std::memory_order_seq_cst);
+    owner->HelpDrain();
+}
+
+// Adds the weak count. The owners together hold one weak reference, so the block outlives the
+// object until the last WeakPtr is gone too.
+template <typename Policy = AtomicCounting>
+class SharedWeakCount : public SharedCount<Policy> {
+public:
+    void AddWeak() noexcept {
+        Policy::Increment(weak_count_);
+    }
+
+    // Adds a strong reference unless the object is already destroyed (WeakPtr::Lock).
+    bool TryAddShared() noexcept {
+        return this->AddSharedIfNonZero();
+    }
+
+    void ReleaseShared() noexcept {
+        if (this->DropShared()) {
+            ReleaseLastShared();
+        }
+    }
+
+    void ReleaseWeak() noexcept {
+        if (Policy::Decrement(weak_count_)) {
+            DestroySelf();
+        }
+    }
+
+protected:
+    // The last owner destroys the object, then gives up the owners' weak reference.
+    void ReleaseLastShared() noexcept final {
+        DestroyObject();
+        ReleaseWeak();
+    }
+
+    virtual void DestroyObject() noexcept = 0;
+    virtual void DestroySelf() noexcept = 0;
+
+    typename Policy::Counter weak_count_{1};
+};
+
+// Control block for an object allocated by the caller and released through `Deleter`.
+template <typename T, typename Deleter, typename Policy = AtomicCounting>
+class ControlBlock : public SharedWeakCount<Policy> {
 public:
-    // Your code goes here...
+    ControlBlock(T* ptr, Deleter deleter) : ptr_(ptr), deleter_(std::move(deleter)) {
+    }
 
 private:
-    // Your code goes here...
-};
\ No newline at end of file
+    void DestroyObject() noexcept override {
+        deleter_(ptr_);
+    }
+    void DestroySelf() noexcept override {
+        delete this;
+    }
+
+    T* ptr_;
+    Deleter deleter_;
+};
+
+// Control block that holds the object itself (MakeShared): one allocation instead of two, and the
+// counters sit next to the object rather than on a separate cache line. Storage is aligned for T,
+// and `new` of the block honours over-aligned T.
+template <typename T, typename Policy = AtomicCounting>
+class InplaceControlBlock : public SharedWeakCount<Policy> {
+public:
+    template <typename... Args>
+    explicit InplaceControlBlock(Args&&... args) {
+        ::new (static_cast<void*>(storage_)) T(std::forward<Args>(args)...);
+    }
+
+    T* Object() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage_));
+    }
+
+private:
+    void DestroyObject() noexcept override {
+        Object()->~T();
+    }
+    void DestroySelf() noexcept override {
+        delete this;
+    }
+
+    alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// AllocateShared's block: like InplaceControlBlock, but the block comes from `Allocator` rebound
+// to the block type and keeps a copy of it, so the memory goes back to the pool it came from. The
+// object is constructed and destroyed through the allocator as well.
+template <typename T, typename Allocator, typename Policy = AtomicCounting>
+class AllocatedControlBlock : public SharedWeakCount<Policy> {
+    using BlockAllocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<AllocatedControlBlock>;
+    using BlockTraits = std::allocator_traits<BlockAllocator>;
+    using Value = std::remove_cv_t<T>;
+    using ValueAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Value>;
+    using ValueTraits = std::allocator_traits<ValueAllocator>;
+
+public:
+    template <typename... Args>
+    static AllocatedControlBlock* Create(const Allocator& alloc, Args&&... args) {
+        BlockAllocator block_alloc(alloc);
+        AllocatedControlBlock* block = BlockTraits::allocate(block_alloc, 1);
+        try {
+            ::new (static_cast<void*>(block))
+                AllocatedControlBlock(block_alloc, std::forward<Args>(args)...);
+        } catch (...) {
+            BlockTraits::deallocate(block_alloc, block, 1);
+            throw;
+        }
+        return block;
+    }
+
+    T* Object() noexcept {
+        return std::launder(Storage());
+    }
+
+private:
+    Value* Storage() noexcept {
+        return reinterpret_cast<Value*>(storage_);
+    }
+
+    template <typename... Args>
+    explicit AllocatedControlBlock(const BlockAllocator& alloc, Args&&... args) : alloc_(alloc) {
+        ValueAllocator value_alloc(alloc_);
+        ValueTraits::construct(value_alloc, Storage(), std::forward<Args>(args)...);
+    }
+
+    void DestroyObject() noexcept override {
+        ValueAllocator value_alloc(alloc_);
+        ValueTraits::destroy(value_alloc, std::launder(Storage()));
+    }
+    void DestroySelf() noexcept override {
+        BlockAllocator alloc(std::move(alloc_));
+        this->~AllocatedControlBlock();
+        BlockTraits::deallocate(alloc, this, 1);
+    }
+
+    // The object comes first, straight after the counters as in InplaceControlBlock.
+    alignas(T) unsigned char storage_[sizeof(T)];
+    BlockAllocator alloc_;
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.h"
+
+// A SharedPtr that threads can load and replace concurrently without a lock, e.g. a configuration
+// that many readers load while a writer occasionally publishes a new one.
+//
+// Split reference counts: every published value sits in a node, and the atomic word holds the
+// node's address together with an external count in its top 16 bits. A reader claims the node by
+// incrementing the external count in the same fetch_add that reads the address, copies the
+// SharedPtr out and then gives its claim back by decrementing the count again, as long as the node
+// is still published. A writer that replaces the node takes over the external count it swapped out
+// and adds it to the node's internal count, which readers still holding a claim decrement instead;
+// whoever brings it to zero frees the node. Each operation is lock-free, and a node is only freed
+// once no reader can reach it, so no address can be reused under a claim.
+//
+// At most 65535 operations may hold a claim at the same time.
+template <typename T, typename Policy = AtomicCounting>
+class AtomicSharedPtr {
+    static_assert(!std::is_same_v<Policy, LocalCounting>,
+                  "a LocalSharedPtr cannot be shared between threads");
+    static_assert(sizeof(std::uintptr_t) == 8, "the external count lives in the address bits");
+
+    using Value = SharedPtr<T, Policy>;
+
+    struct Node {
+        explicit Node(Value value) : value(std::move(value)) {
+        }
+        Value value;
+        std::atomic<std::int64_t> count{0};
+    };
+
+public:
+    constexpr AtomicSharedPtr() noexcept = default;
+    explicit AtomicSharedPtr(Value desired) : word_(Pack(MakeNode(std::move(desired)))) {
+    }
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+    // No other thread may be using it.
+    ~AtomicSharedPtr() {
+        delete NodeOf(word_.load(std::memory_order_relaxed));
+    }
+
+    Value Load() const;
+    void Store(Value desired) {
+        Exchange(std::move(desired));
+    }
+    Value Exchange(Value desired);
+
+    // Replaces the value with `desired` if it shares ownership with, and points to the same
+    // object as, `expected`; otherwise loads the current value into `expected`.
+    bool CompareExchange(Value& expected, Value desired);
+
+    bool IsLockFree() const noexcept {
+        return word_.is_lock_free();
+    }
+
+private:
+    static constexpr int kCountShift = 48;
+    static constexpr std::uintptr_t kOneClaim = std::uintptr_t{1} << kCountShift;
+    static constexpr std::uintptr_t kAddressMask = kOneClaim - 1;
+
+    static std::uintptr_t Pack(Node* node) noexcept {
+        return reinterpret_cast<std::uintptr_t>(node);
+    }
+    static Node* NodeOf(std::uintptr_t word) noexcept {
+        return reinterpret_cast<Node*>(word & kAddressMask);
+    }
+    static std::int64_t ClaimsOf(std::uintptr_t word) noexcept {
+        return static_cast<std::int64_t>(word >> kCountShift);
+    }
+
+    // An empty value gets no node, so that storing one does not allocate.
+    static Node* MakeNode(Value value) {
+        if (value.ptr_ == nullptr && value.control_ == nullptr) {
+            return nullptr;
+        }
+        return new Node(std::move(value));
+    }
+
+    static bool Equivalent(const Node* node, const Value& value) noexcept {
+        return node == nullptr ? value.ptr_ == nullptr && value.control_ == nullptr
+                               : node->value.ptr_ == value.ptr_ &&
+                                     node->value.control_ == value.control_;
+    }
+
+    // Claims whatever node is published; `word` includes the claim.
+    std::uintptr_t Claim() const noexcept {
+        return word_.fetch_add(kOneClaim, std::memory_order_acquire) + kOneClaim;
+    }
+
+    // Gives back a claim taken by Claim. If the node has been swapped out meanwhile, the claim
+    // went into its internal count with the rest of the external one.
+    void Unclaim(std::uintptr_t word) const noexcept {
+        Node* node = NodeOf(word);
+        while (NodeOf(word) == node) {
+            if (word_.compare_exchange_weak(word, word - kOneClaim, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        DropClaim(node);
+    }
+
+    static void DropClaim(Node* node) noexcept {
+        if (node != nullptr && node->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete node;
+        }
+    }
+
+    // Called once a node is swapped out with `claims` claims still on it.
+    static void Retire(Node* node, std::int64_t claims) noexcept {
+        if (node->count.fetch_add(claims, std::memory_order_acq_rel) + claims == 0) {
+            delete node;
+        }
+    }
+
+    mutable std::atomic<std::uintptr_t> word_{0};
+};
+
+template <typename T, typename Policy>
+typename AtomicSharedPtr<T, Policy>::Value AtomicSharedPtr<T, Policy>::Load() const {
+    std::uintptr_t word = Claim();
+    Node* node = NodeOf(word);
+    Value result = node != nullptr ? node->value : Value();
+    Unclaim(word);
+    return result;
+}
+
+// With no claims left on the old node nobody else can reach it, so its value is moved out rather
+// than copied.
+template <typename T, typename Policy>
+typename AtomicSharedPtr<T, Policy>::Value AtomicSharedPtr<T, Policy>::Exchange(Value desired) {
+    Node* replacement = MakeNode(std::move(desired));
+    std::uintptr_t word = word_.exchange(Pack(replacement), std::memory_order_acq_rel);
+    Node* node = NodeOf(word);
+    if (node == nullptr) {
+        return Value();
+    }
+    std::int64_t claims = ClaimsOf(word);
+    if (claims == 0) {
+        Value result = std::move(node->value);
+        delete node;
+        return result;
+    }
+    Value result = node->value;
+    Retire(node, claims);
+    return result;
+}
+
+template <typename T, typename Policy>
+bool AtomicSharedPtr<T, Policy>::CompareExchange(Value& expected, Value desired) {
+    Node* replacement = MakeNode(std::move(desired));
+    for (;;) {
+        std::uintptr_t word = Claim();
+        Node* node = NodeOf(word);
+        if (!Equivalent(node, expected)) {
+            expected = node != nullptr ? node->value : Value();
+            Unclaim(word);
+            delete replacement;
+            return false;
+        }
+        // Other readers coming and going change the count but not the node; retry only those.
+        while (NodeOf(word) == node) {
+            if (word_.compare_exchange_weak(word, Pack(replacement), std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                if (node != nullptr) {
+                    Retire(node, ClaimsOf(word) - 1);
+                }
+                return true;
+            }
+        }
+        // Replaced meanwhile; the claim is now in the old node's internal count.
+        DropClaim(node);
+    }
+}
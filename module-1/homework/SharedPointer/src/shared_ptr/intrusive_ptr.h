@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "../control/control.h"
+
+// RefCounted
+// Mixin that keeps the reference count inside the object, for IntrusivePtr. T is the class that
+// derives from it and is deleted through `delete static_cast<T*>`, so a hierarchy needs a virtual
+// destructor, as with SharedPtr(new Derived) behind a Base pointer. Policy is one of the counting
+// policies in control.h: AtomicCounting, LocalCounting for single-threaded objects, or
+// PaddedCounting. There is no weak count.
+template <typename T, typename Policy = AtomicCounting>
+class RefCounted {
+public:
+    std::size_t UseCount() const noexcept {
+        return Policy::Load(count_);
+    }
+
+protected:
+    constexpr RefCounted() noexcept = default;
+    // A copy is a new object that nobody owns yet.
+    RefCounted(const RefCounted&) noexcept {
+    }
+    RefCounted& operator=(const RefCounted&) noexcept {
+        return *this;
+    }
+    ~RefCounted() = default;
+
+private:
+    template <typename U>
+    friend class IntrusivePtr;
+
+    void AddRef() const noexcept {
+        Policy::Increment(count_);
+    }
+    void Release() const noexcept {
+        if (Policy::Decrement(count_)) {
+            Destroy(this);
+        }
+    }
+    // Out of line: once the delete is inlined into a caller that releases two handles to the
+    // same object, GCC's -Wuse-after-free cannot tell that only the last release deletes, and
+    // flags the other one's decrement.
+#if defined(__GNUC__) && !defined(__clang__)
+    [[gnu::noinline]]
+#endif
+    static void Destroy(const RefCounted* self) noexcept {
+        delete static_cast<const T*>(self);
+    }
+
+    mutable typename Policy::Counter count_{0};
+};
+// RefCounted
+
+// IntrusivePtr
+// SharedPtr's interface minus WeakPtr, for T derived from RefCounted. The handle is one pointer
+// and there is no control block: the object is allocated on its own, by whatever means, and a
+// count of zero deletes it. An IntrusivePtr can be made again from a raw pointer at any time,
+// e.g. from `this`, and joins the existing owners.
+template <typename T>
+class IntrusivePtr {
+public:
+    using element_type = T;
+
+    constexpr IntrusivePtr() noexcept = default;
+    ~IntrusivePtr();
+
+    explicit IntrusivePtr(T* p) noexcept;
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept;
+    IntrusivePtr(IntrusivePtr&& other) noexcept;
+
+    template <typename Y>
+    IntrusivePtr(const IntrusivePtr<Y>& other) noexcept;  // NOLINT
+    template <typename Y>
+    IntrusivePtr(IntrusivePtr<Y>&& other) noexcept;  // NOLINT
+
+    IntrusivePtr& operator=(const IntrusivePtr& r) noexcept;
+    IntrusivePtr& operator=(IntrusivePtr&& r) noexcept;
+
+    template <typename Y>
+    IntrusivePtr& operator=(const IntrusivePtr<Y>& r) noexcept;
+    template <typename Y>
+    IntrusivePtr& operator=(IntrusivePtr<Y>&& r) noexcept;
+
+    // Modifiers
+    void Reset() noexcept;
+    void Reset(T* p) noexcept;
+    void Swap(IntrusivePtr& other) noexcept;
+
+    // Observers
+    T* Get() const noexcept;
+    int64_t UseCount() const noexcept;
+    T& operator*() const noexcept;
+    T* operator->() const noexcept;
+    explicit operator bool() const noexcept;
+
+private:
+    template <typename U>
+    friend class IntrusivePtr;
+
+    T* ptr_ = nullptr;
+};
+
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeIntrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T>
+IntrusivePtr<T>::~IntrusivePtr() {
+    if (ptr_ != nullptr) {
+        ptr_->Release();
+    }
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(T* p) noexcept : ptr_(p) {
+    if (ptr_ != nullptr) {
+        ptr_->AddRef();
+    }
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.ptr_) {
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(IntrusivePtr&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)) {
+}
+
+template <typename T>
+template <typename Y>
+IntrusivePtr<T>::IntrusivePtr(const IntrusivePtr<Y>& other) noexcept : IntrusivePtr(other.ptr_) {
+}
+
+template <typename T>
+template <typename Y>
+IntrusivePtr<T>::IntrusivePtr(IntrusivePtr<Y>&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)) {
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(const IntrusivePtr& r) noexcept {
+    IntrusivePtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(IntrusivePtr&& r) noexcept {
+    IntrusivePtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T>
+template <typename Y>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(const IntrusivePtr<Y>& r) noexcept {
+    IntrusivePtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T>
+template <typename Y>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(IntrusivePtr<Y>&& r) noexcept {
+    IntrusivePtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T>
+void IntrusivePtr<T>::Reset() noexcept {
+    IntrusivePtr().Swap(*this);
+}
+
+template <typename T>
+void IntrusivePtr<T>::Reset(T* p) noexcept {
+    IntrusivePtr(p).Swap(*this);
+}
+
+template <typename T>
+void IntrusivePtr<T>::Swap(IntrusivePtr& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+}
+
+template <typename T>
+T* IntrusivePtr<T>::Get() const noexcept {
+    return ptr_;
+}
+
+template <typename T>
+int64_t IntrusivePtr<T>::UseCount() const noexcept {
+    return ptr_ != nullptr ? static_cast<int64_t>(ptr_->UseCount()) : 0;
+}
+
+template <typename T>
+T& IntrusivePtr<T>::operator*() const noexcept {
+    return *ptr_;
+}
+
+template <typename T>
+T* IntrusivePtr<T>::operator->() const noexcept {
+    return ptr_;
+}
+
+template <typename T>
+IntrusivePtr<T>::operator bool() const noexcept {
+    return ptr_ != nullptr;
+}
+// IntrusivePtr
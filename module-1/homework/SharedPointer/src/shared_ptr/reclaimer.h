@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+
+// Reclaimer
+// Takes objects whose last owner is gone and destroys them later, off the thread that dropped
+// them: on Drain, or every `period` on a background thread of its own. Retiring an object is one
+// small allocation and one CAS, however large the graph its destructor would tear down.
+//
+// The queue is a stack that producers push to and Drain empties in one exchange, so it needs no
+// protection against ABA. Objects come out in batches, most recently retired first. Destructors
+// that retire more objects to the same Reclaimer are fine; Drain keeps going until it is empty.
+class Reclaimer {
+public:
+    Reclaimer() = default;
+    explicit Reclaimer(std::chrono::microseconds period)
+        : worker_([this, period] { Run(period); }) {
+    }
+    Reclaimer(const Reclaimer&) = delete;
+    Reclaimer& operator=(const Reclaimer&) = delete;
+
+    // Stops the background thread and destroys whatever is still queued.
+    ~Reclaimer() {
+        if (worker_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            worker_.join();
+        }
+        Drain();
+    }
+
+    // Queues `p` for `delete`. Should the entry not fit in memory, `p` is deleted right away.
+    template <typename T>
+    void Retire(T* p) noexcept {
+        Entry* entry = new (std::nothrow) Entry{p, &Delete<T>, nullptr};
+        if (entry == nullptr) {
+            delete p;
+            return;
+        }
+        entry->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(entry->next, entry, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    // Destroys everything queued so far, and whatever those destructors queue in turn; returns
+    // how many objects that was. Safe to call from any thread, also while the worker runs.
+    std::size_t Drain() noexcept {
+        std::size_t count = 0;
+        while (Entry* entry = head_.exchange(nullptr, std::memory_order_acquire)) {
+            while (entry != nullptr) {
+                Entry* next = entry->next;
+                entry->destroy(entry->object);
+                delete entry;
+                entry = next;
+                ++count;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Entry {
+        void* object;
+        void (*destroy)(void*);
+        Entry* next;
+    };
+
+    template <typename T>
+    static void Delete(void* p) {
+        delete static_cast<T*>(p);
+    }
+
+    void Run(std::chrono::microseconds period) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, period, [this] { return stop_; })) {
+            lock.unlock();
+            Drain();
+            lock.lock();
+        }
+    }
+
+    std::atomic<Entry*> head_{nullptr};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+// Deleter for SharedPtr (or anything else that takes one) that hands the object to a Reclaimer
+// instead of deleting it: SharedPtr<Graph>(new Graph, DeferredDelete(reclaimer)). The Reclaimer
+// must outlive every pointer that uses it. Only the object is deferred; the control block goes as
+// usual. Not for arrays, which need delete[].
+class DeferredDelete {
+public:
+    explicit DeferredDelete(Reclaimer& reclaimer) noexcept : reclaimer_(&reclaimer) {
+    }
+
+    template <typename T>
+    void operator()(T* p) const noexcept {
+        reclaimer_->Retire(p);
+    }
+
+private:
+    Reclaimer* reclaimer_;
+};
+// Reclaimer
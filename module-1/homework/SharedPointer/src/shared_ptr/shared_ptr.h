@@ -1,15 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
 #include "../control/control.h"
 
 // SharedPtr
-template <typename T>
+template <typename T, typename Policy = AtomicCounting>
 class WeakPtr;
 
-template <typename T>
+template <typename T, typename Policy = AtomicCounting>
+class EnableSharedFromThis;
+
+template <typename T, typename Policy = AtomicCounting>
 class SharedPtr {
 public:
-    using element_type =     // Your code goes here...
+    using element_type = std::remove_extent_t<T>;
 
     constexpr SharedPtr() noexcept = default;
     ~SharedPtr();
@@ -23,15 +32,27 @@ public:
     SharedPtr(const SharedPtr& other) noexcept;
     SharedPtr(SharedPtr&& other) noexcept;
 
+    template <typename Y>
+    SharedPtr(const SharedPtr<Y, Policy>& other) noexcept;  // NOLINT
+    template <typename Y>
+    SharedPtr(SharedPtr<Y, Policy>&& other) noexcept;  // NOLINT
+
+    // Aliasing: shares ownership with `other` but points to `p`, typically a member of the
+    // object `other` owns.
+    template <typename Y>
+    SharedPtr(const SharedPtr<Y, Policy>& other, element_type* p) noexcept;
+    template <typename Y>
+    SharedPtr(SharedPtr<Y, Policy>&& other, element_type* p) noexcept;
+
     SharedPtr& operator=(const SharedPtr& r) noexcept;
 
     template <typename Y>
-    SharedPtr& operator=(const SharedPtr<Y>& r) noexcept;
+    SharedPtr& operator=(const SharedPtr<Y, Policy>& r) noexcept;
 
     SharedPtr& operator=(SharedPtr&& r) noexcept;
 
     template <typename Y>
-    SharedPtr& operator=(SharedPtr<Y>&& r) noexcept;
+    SharedPtr& operator=(SharedPtr<Y, Policy>&& r) noexcept;
 
     // Modifiers
     void Reset() noexcept;
@@ -45,44 +66,253 @@ public:
     void Swap(SharedPtr& other) noexcept;
 
     // Observers
-    T* Get() const noexcept;
+    element_type* Get() const noexcept;
     int64_t UseCount() const noexcept;
     T& operator*() const noexcept;
-    T* operator->() const noexcept;
+    element_type* operator->() const noexcept;
     element_type& operator[](std::ptrdiff_t idx) const;
     explicit operator bool() const noexcept;
 
-    template <typename U>
+    template <typename U, typename P>
     friend class WeakPtr;
 
 private:
-    // Your code goes here...
+    template <typename U, typename P>
+    friend class SharedPtr;
+    template <typename U, typename P>
+    friend class AtomicSharedPtr;
+
+    template <typename U, typename P, typename... Args>
+    friend SharedPtr<U, P> MakeShared(Args&&... args);
+    template <typename U, typename P, typename Allocator, typename... Args>
+    friend SharedPtr<U, P> AllocateShared(const Allocator& alloc, Args&&... args);
+
+    // Called on taking ownership of `p` as EnableSharedFromThisFor(p, p): points an
+    // EnableSharedFromThis base of the object at this pointer's block, unless the object is owned
+    // already. `p` is the object's own type, which may differ from T (a base, or a const view).
+    // Anything else picks the no-op.
+    template <typename Y, typename U>
+    void EnableSharedFromThisFor(Y* p, const EnableSharedFromThis<U, Policy>* base) noexcept;
+    template <typename Y>
+    void EnableSharedFromThisFor(Y*, const volatile void*) noexcept {
+    }
+
+    element_type* ptr_ = nullptr;
+    SharedWeakCount<Policy>* control_ = nullptr;
 };
 
 
 // MakeShared
-// Your code goes here...
+// The object is built inside its control block, so the pair costs a single allocation.
+template <typename T, typename Policy = AtomicCounting, typename... Args>
+SharedPtr<T, Policy> MakeShared(Args&&... args) {
+    auto* control = new InplaceControlBlock<T, Policy>(std::forward<Args>(args)...);
+    SharedPtr<T, Policy> result;
+    result.ptr_ = control->Object();
+    result.control_ = control;
+    result.EnableSharedFromThisFor(result.ptr_, result.ptr_);
+    return result;
+}
+
+// Object and counters in one block from `alloc`, e.g. a pool-backed CustomAllocator. The block
+// keeps a copy of the allocator and is returned through it.
+template <typename T, typename Policy = AtomicCounting, typename Allocator, typename... Args>
+SharedPtr<T, Policy> AllocateShared(const Allocator& alloc, Args&&... args) {
+    auto* control =
+        AllocatedControlBlock<T, Allocator, Policy>::Create(alloc, std::forward<Args>(args)...);
+    SharedPtr<T, Policy> result;
+    result.ptr_ = control->Object();
+    result.control_ = control;
+    result.EnableSharedFromThisFor(result.ptr_, result.ptr_);
+    return result;
+}
 // MakeShared
 
 // SharedPtr
-// Your code goes here...
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::~SharedPtr() {
+    if (control_ != nullptr) {
+        control_->ReleaseShared();
+    }
+}
+
+// Arrays are released with delete[], everything else through the pointer's own type so that a
+// SharedPtr<Base> made from a Derived* still runs ~Derived.
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(Y* p) : ptr_(p) {
+    using Deleter = std::conditional_t<std::is_array_v<T>, std::default_delete<T>,
+                                       std::default_delete<Y>>;
+    try {
+        control_ = new ControlBlock<Y, Deleter, Policy>(p, Deleter());
+    } catch (...) {
+        Deleter()(p);
+        throw;
+    }
+    EnableSharedFromThisFor(p, p);
+}
+
+template <typename T, typename Policy>
+template <typename Y, typename Deleter>
+SharedPtr<T, Policy>::SharedPtr(Y* p, Deleter deleter) noexcept
+    : ptr_(p), control_(new ControlBlock<Y, Deleter, Policy>(p, std::move(deleter))) {
+    EnableSharedFromThisFor(p, p);
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddShared();
+    }
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr<Y, Policy>& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddShared();
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr<Y, Policy>&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr<Y, Policy>& other, element_type* p) noexcept
+    : ptr_(p), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddShared();
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr<Y, Policy>&& other, element_type* p) noexcept
+    : ptr_(p), control_(std::exchange(other.control_, nullptr)) {
+    other.ptr_ = nullptr;
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(const SharedPtr& r) noexcept {
+    SharedPtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(const SharedPtr<Y, Policy>& r) noexcept {
+    SharedPtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(SharedPtr&& r) noexcept {
+    SharedPtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(SharedPtr<Y, Policy>&& r) noexcept {
+    SharedPtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+void SharedPtr<T, Policy>::Reset() noexcept {
+    SharedPtr().Swap(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+void SharedPtr<T, Policy>::Reset(Y* p) noexcept {
+    SharedPtr(p).Swap(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Y, typename Deleter>
+void SharedPtr<T, Policy>::Reset(Y* p, Deleter deleter) noexcept {
+    SharedPtr(p, std::move(deleter)).Swap(*this);
+}
+
+template <typename T, typename Policy>
+void SharedPtr<T, Policy>::Swap(SharedPtr& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    std::swap(control_, other.control_);
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type* SharedPtr<T, Policy>::Get() const noexcept {
+    return ptr_;
+}
+
+template <typename T, typename Policy>
+int64_t SharedPtr<T, Policy>::UseCount() const noexcept {
+    return control_ != nullptr ? static_cast<int64_t>(control_->UseCount()) : 0;
+}
+
+template <typename T, typename Policy>
+T& SharedPtr<T, Policy>::operator*() const noexcept {
+    return *ptr_;
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type* SharedPtr<T, Policy>::operator->() const noexcept {
+    return ptr_;
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type& SharedPtr<T, Policy>::operator[](
+    std::ptrdiff_t idx) const {
+    return ptr_[idx];
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::operator bool() const noexcept {
+    return ptr_ != nullptr;
+}
+
+// Arrays are left alone, and so is a const object, whose base cannot be written.
+// The weak reference aliases this block with a U*, so it does not depend on T. Like
+// std::shared_ptr, a const object still gets a mutable U: the const is only the owner's view.
+template <typename T, typename Policy>
+template <typename Y, typename U>
+void SharedPtr<T, Policy>::EnableSharedFromThisFor(
+    Y* p, const EnableSharedFromThis<U, Policy>* base) noexcept {
+    if constexpr (!std::is_array_v<T>) {
+        if (base != nullptr && base->weak_this_.Expired()) {
+            base->weak_this_ = SharedPtr<U, Policy>(*this, const_cast<U*>(static_cast<const U*>(p)));
+        }
+    }
+}
 // SharedPtr
 
 // WeakPtr
-template <typename T>
+template <typename T, typename Policy>
 class WeakPtr {
 
 public:
-    using element_type =     // Your code goes here...
+    using element_type = std::remove_extent_t<T>;
 
     // Special-member functions
     constexpr WeakPtr() noexcept = default;
     template <typename Y>
-    explicit WeakPtr(const SharedPtr<Y>& other);
+    explicit WeakPtr(const SharedPtr<Y, Policy>& other);
     WeakPtr(const WeakPtr& other) noexcept;
     WeakPtr(WeakPtr&& other) noexcept;
     template <typename Y>
-    WeakPtr& operator=(const SharedPtr<Y>& other);
+    WeakPtr& operator=(const SharedPtr<Y, Policy>& other);
     WeakPtr& operator=(const WeakPtr& other) noexcept;
     WeakPtr& operator=(WeakPtr&& other) noexcept;
 
@@ -90,19 +320,163 @@ public:
 
     // Modifiers
     void Reset() noexcept;
-    void Swap(WeakPtr<T>& other) noexcept;
+    void Swap(WeakPtr<T, Policy>& other) noexcept;
 
     // Observers
-    bool Expired() noexcept;
-    SharedPtr<T> Lock() const noexcept;
+    bool Expired() const noexcept;
+    SharedPtr<T, Policy> Lock() const noexcept;
 
-    template <typename U>
+    template <typename U, typename P>
     friend class SharedPtr;
 
-public:
-    // Your code goes here...
+private:
+    element_type* ptr_ = nullptr;
+    SharedWeakCount<Policy>* control_ = nullptr;
 };
 
 // WeakPtr
-// Your code goes here...
-// WeakPtr
\ No newline at end of file
+template <typename T, typename Policy>
+template <typename Y>
+WeakPtr<T, Policy>::WeakPtr(const SharedPtr<Y, Policy>& other)
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddWeak();
+    }
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::WeakPtr(const WeakPtr& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddWeak();
+    }
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::WeakPtr(WeakPtr&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(const SharedPtr<Y, Policy>& other) {
+    WeakPtr(other).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(const WeakPtr& other) noexcept {
+    WeakPtr(other).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(WeakPtr&& other) noexcept {
+    WeakPtr(std::move(other)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::~WeakPtr() {
+    if (control_ != nullptr) {
+        control_->ReleaseWeak();
+    }
+}
+
+template <typename T, typename Policy>
+void WeakPtr<T, Policy>::Reset() noexcept {
+    WeakPtr().Swap(*this);
+}
+
+template <typename T, typename Policy>
+void WeakPtr<T, Policy>::Swap(WeakPtr<T, Policy>& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    std::swap(control_, other.control_);
+}
+
+// A relaxed load. The answer may be stale by the time it is used, so it orders nothing: `false`
+// does not promise that Lock will succeed, only Lock itself can take a reference.
+template <typename T, typename Policy>
+bool WeakPtr<T, Policy>::Expired() const noexcept {
+    return control_ == nullptr || control_->UseCount() == 0;
+}
+
+// Never takes a lock and never races with the last owner: TryAddShared only increments a count
+// that is not zero, in one CAS, so once the count has reached zero no Lock can bring it back.
+template <typename T, typename Policy>
+SharedPtr<T, Policy> WeakPtr<T, Policy>::Lock() const noexcept {
+    SharedPtr<T, Policy> result;
+    if (control_ != nullptr && control_->TryAddShared()) {
+        result.ptr_ = ptr_;
+        result.control_ = control_;
+    }
+    return result;
+}
+// WeakPtr
+
+// LocalSharedPtr
+// Same interface with plain integer counts, for objects owned and observed by one thread only.
+// Copies and resets skip the locked read-modify-write; sharing one across threads is a data race.
+template <typename T>
+using LocalSharedPtr = SharedPtr<T, LocalCounting>;
+
+template <typename T>
+using LocalWeakPtr = WeakPtr<T, LocalCounting>;
+
+template <typename T, typename... Args>
+LocalSharedPtr<T> MakeLocalShared(Args&&... args) {
+    return MakeShared<T, LocalCounting>(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Allocator, typename... Args>
+LocalSharedPtr<T> AllocateLocalShared(const Allocator& alloc, Args&&... args) {
+    return AllocateShared<T, LocalCounting>(alloc, std::forward<Args>(args)...);
+}
+// LocalSharedPtr
+
+// EnableSharedFromThis
+// Base for objects that need an owning pointer to themselves, e.g. to hand to a callback. The
+// SharedPtr that takes ownership of the object, through MakeShared, AllocateShared or a raw
+// pointer, leaves a weak reference to its block here, so SharedFromThis shares that block instead
+// of allocating a second one that would delete the object twice.
+template <typename T, typename Policy>
+class EnableSharedFromThis {
+public:
+    // Throws std::bad_weak_ptr unless a SharedPtr owns the object.
+    SharedPtr<T, Policy> SharedFromThis() {
+        return Lock();
+    }
+    SharedPtr<const T, Policy> SharedFromThis() const {
+        return Lock();
+    }
+
+    WeakPtr<T, Policy> WeakFromThis() noexcept {
+        return weak_this_;
+    }
+
+protected:
+    constexpr EnableSharedFromThis() noexcept = default;
+    // A copy is a new object that nobody owns yet.
+    EnableSharedFromThis(const EnableSharedFromThis&) noexcept {
+    }
+    EnableSharedFromThis& operator=(const EnableSharedFromThis&) noexcept {
+        return *this;
+    }
+    ~EnableSharedFromThis() = default;
+
+private:
+    template <typename U, typename P>
+    friend class SharedPtr;
+
+    SharedPtr<T, Policy> Lock() const {
+        SharedPtr<T, Policy> self = weak_this_.Lock();
+        if (!self) {
+            throw std::bad_weak_ptr();
+        }
+        return self;
+    }
+
+    // Set through a const base when the owner holds the object as const.
+    mutable WeakPtr<T, Policy> weak_this_;
+};
+// EnableSharedFromThis